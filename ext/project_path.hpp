@@ -0,0 +1,2 @@
+#pragma once
+#define PROJECT_SOURCE_DIR "/root/repo/"
@@ -0,0 +1,260 @@
+// internal
+#include "aabb_tree.hpp"
+
+// stlib
+#include <algorithm>
+
+constexpr float AABBTree::FAT_MARGIN;
+const int AABBTree::NULL_NODE;
+
+AABBTree::Box AABBTree::merge(const Box &a, const Box &b)
+{
+	return {std::min(a.min_x, b.min_x), std::min(a.min_y, b.min_y), std::max(a.max_x, b.max_x), std::max(a.max_y, b.max_y)};
+}
+
+float AABBTree::perimeter(const Box &box)
+{
+	return 2.f * ((box.max_x - box.min_x) + (box.max_y - box.min_y));
+}
+
+// Slab test of the segment against the box
+bool AABBTree::segment_overlaps(const Box &box, vec2 from, vec2 to)
+{
+	float t_min = 0.f;
+	float t_max = 1.f;
+	vec2 d = to - from;
+	const float box_min[2] = {box.min_x, box.min_y};
+	const float box_max[2] = {box.max_x, box.max_y};
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (d[axis] == 0.f)
+		{
+			if (from[axis] < box_min[axis] || from[axis] > box_max[axis])
+				return false;
+			continue;
+		}
+		float t1 = (box_min[axis] - from[axis]) / d[axis];
+		float t2 = (box_max[axis] - from[axis]) / d[axis];
+		t_min = std::max(t_min, std::min(t1, t2));
+		t_max = std::min(t_max, std::max(t1, t2));
+		if (t_min > t_max)
+			return false;
+	}
+	return true;
+}
+
+int AABBTree::allocate_node()
+{
+	if (free_list == NULL_NODE)
+	{
+		nodes.emplace_back();
+		return (int)nodes.size() - 1;
+	}
+	int node = free_list;
+	free_list = nodes[node].parent;
+	nodes[node] = Node();
+	return node;
+}
+
+void AABBTree::free_node(int node)
+{
+	nodes[node].parent = free_list;
+	nodes[node].height = -1;
+	free_list = node;
+}
+
+void AABBTree::insert_leaf(int leaf)
+{
+	if (root == NULL_NODE)
+	{
+		root = leaf;
+		nodes[root].parent = NULL_NODE;
+		return;
+	}
+
+	// Find the best sibling by the surface area heuristic (perimeter in 2D)
+	Box leaf_box = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].is_leaf())
+	{
+		const Node &node = nodes[index];
+		float area = perimeter(node.box);
+		float combined_area = perimeter(merge(node.box, leaf_box));
+
+		// cost of creating a new parent for this node and the new leaf
+		float cost = 2.f * combined_area;
+		// minimum cost of pushing the leaf further down the tree
+		float inheritance_cost = 2.f * (combined_area - area);
+
+		float child_costs[2];
+		int children[2] = {node.child1, node.child2};
+		for (int c = 0; c < 2; c++)
+		{
+			const Node &child = nodes[children[c]];
+			float merged = perimeter(merge(leaf_box, child.box));
+			child_costs[c] = (child.is_leaf() ? merged : merged - perimeter(child.box)) + inheritance_cost;
+		}
+
+		if (cost < child_costs[0] && cost < child_costs[1])
+			break;
+		index = child_costs[0] < child_costs[1] ? children[0] : children[1];
+	}
+	int sibling = index;
+
+	// Create a new parent for the sibling and the leaf
+	int old_parent = nodes[sibling].parent;
+	int new_parent = allocate_node();
+	nodes[new_parent].parent = old_parent;
+	nodes[new_parent].box = merge(leaf_box, nodes[sibling].box);
+	nodes[new_parent].height = nodes[sibling].height + 1;
+	nodes[new_parent].child1 = sibling;
+	nodes[new_parent].child2 = leaf;
+	nodes[sibling].parent = new_parent;
+	nodes[leaf].parent = new_parent;
+	if (old_parent == NULL_NODE)
+		root = new_parent;
+	else if (nodes[old_parent].child1 == sibling)
+		nodes[old_parent].child1 = new_parent;
+	else
+		nodes[old_parent].child2 = new_parent;
+
+	// Refit and rebalance the ancestors
+	for (index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent)
+	{
+		index = balance(index);
+		Node &node = nodes[index];
+		node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+		node.box = merge(nodes[node.child1].box, nodes[node.child2].box);
+	}
+}
+
+void AABBTree::remove_leaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = NULL_NODE;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grand_parent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+	free_node(parent);
+
+	if (grand_parent == NULL_NODE)
+	{
+		root = sibling;
+		nodes[sibling].parent = NULL_NODE;
+		return;
+	}
+
+	// The sibling takes the place of the parent
+	if (nodes[grand_parent].child1 == parent)
+		nodes[grand_parent].child1 = sibling;
+	else
+		nodes[grand_parent].child2 = sibling;
+	nodes[sibling].parent = grand_parent;
+
+	for (int index = grand_parent; index != NULL_NODE; index = nodes[index].parent)
+	{
+		index = balance(index);
+		Node &node = nodes[index];
+		node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+		node.box = merge(nodes[node.child1].box, nodes[node.child2].box);
+	}
+}
+
+// Rotates the taller child of a up if the children's heights differ by more than one
+// Returns the node now at a's position
+int AABBTree::balance(int a)
+{
+	if (nodes[a].is_leaf() || nodes[a].height < 2)
+		return a;
+
+	int b = nodes[a].child1;
+	int c = nodes[a].child2;
+	int difference = nodes[c].height - nodes[b].height;
+	if (difference >= -1 && difference <= 1)
+		return a;
+
+	// the taller child moves up, its taller child stays with it and its shorter child goes to a
+	int up = difference > 1 ? c : b;
+	int other = difference > 1 ? b : c;
+	int f = nodes[up].child1;
+	int g = nodes[up].child2;
+	int keep = nodes[f].height > nodes[g].height ? f : g;
+	int give = keep == f ? g : f;
+
+	// up replaces a under a's parent
+	nodes[up].parent = nodes[a].parent;
+	if (nodes[up].parent == NULL_NODE)
+		root = up;
+	else if (nodes[nodes[up].parent].child1 == a)
+		nodes[nodes[up].parent].child1 = up;
+	else
+		nodes[nodes[up].parent].child2 = up;
+
+	nodes[up].child1 = a;
+	nodes[up].child2 = keep;
+	nodes[a].parent = up;
+
+	// a keeps its other child and adopts give in place of up
+	if (up == c)
+		nodes[a].child2 = give;
+	else
+		nodes[a].child1 = give;
+	nodes[give].parent = a;
+
+	nodes[a].box = merge(nodes[other].box, nodes[give].box);
+	nodes[a].height = 1 + std::max(nodes[other].height, nodes[give].height);
+	nodes[up].box = merge(nodes[a].box, nodes[keep].box);
+	nodes[up].height = 1 + std::max(nodes[a].height, nodes[keep].height);
+	return up;
+}
+
+void AABBTree::update(Entity e, unsigned int body, const Box &box, bool is_static)
+{
+	unsigned int proxy = leaves.update(e, [this](unsigned int stale)
+																		 { remove_proxy(stale); });
+
+	Box fat_box = {box.min_x - FAT_MARGIN, box.min_y - FAT_MARGIN, box.max_x + FAT_MARGIN, box.max_y + FAT_MARGIN};
+	if (proxy == ProxyTable<int>::INVALID_INDEX)
+	{
+		int leaf = allocate_node();
+		leaves.add(e, leaf);
+
+		Node &node = nodes[leaf];
+		node.box = fat_box;
+		node.entity = e;
+		node.body = body;
+		node.is_static = is_static;
+		insert_leaf(leaf);
+		return;
+	}
+
+	int leaf = leaves.proxies[proxy];
+	Node &node = nodes[leaf];
+	node.body = body;
+	node.is_static = is_static;
+	if (!contains(node.box, box))
+	{
+		remove_leaf(leaf);
+		nodes[leaf].box = fat_box;
+		insert_leaf(leaf);
+	}
+}
+
+void AABBTree::remove_proxy(unsigned int proxy)
+{
+	int leaf = leaves.proxies[proxy];
+	remove_leaf(leaf);
+	free_node(leaf);
+	// nothing in the tree refers to proxy indices
+	leaves.remove(proxy, [](unsigned int, unsigned int) {});
+}
+
+void AABBTree::remove_stale()
+{
+	leaves.remove_stale([this](unsigned int proxy)
+											{ remove_proxy(proxy); });
+}
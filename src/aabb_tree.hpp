@@ -0,0 +1,133 @@
+#pragma once
+
+// stlib
+#include <vector>
+
+// internal
+#include "common.hpp"
+#include "proxy_table.hpp"
+
+// Dynamic AABB tree (bounding volume hierarchy) broadphase for bodies of any size
+// Leaves store the body's box fattened by FAT_MARGIN; a moving body is only re-inserted when its box
+// leaves the fattened one, otherwise update() just refreshes the leaf. The tree is kept balanced by
+// rotations on the way up after every insertion and removal, so queries stay logarithmic.
+// Proxies are kept in a ProxyTable like the ones of SpatialGrid.
+class AABBTree
+{
+public:
+	static constexpr float FAT_MARGIN = 15.f;
+
+	struct Box
+	{
+		float min_x, min_y, max_x, max_y;
+	};
+
+	// Marks the start of a physics step, proxies that are not updated before remove_stale() are dropped
+	void begin_update() { leaves.begin_update(); }
+
+	// Inserts or moves the proxy of e; body is the caller's index for e in this step
+	void update(Entity e, unsigned int body, const Box &box, bool is_static);
+
+	// Drops the proxies of entities that were not updated in this step
+	void remove_stale();
+
+	// Calls callback(body, is_static) for every proxy whose fattened box overlaps box
+	template <typename Callback>
+	void query(const Box &box, Callback callback)
+	{
+		stack.clear();
+		if (root != NULL_NODE)
+			stack.push_back(root);
+		while (!stack.empty())
+		{
+			const Node &node = nodes[stack.back()];
+			stack.pop_back();
+			if (!overlaps(node.box, box))
+				continue;
+			if (node.is_leaf())
+			{
+				callback(node.body, node.is_static);
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	// Calls callback(entity, body) for every proxy whose fattened box the segment from -> to crosses,
+	// until the callback returns false
+	template <typename Callback>
+	void ray_cast(vec2 from, vec2 to, Callback callback)
+	{
+		stack.clear();
+		if (root != NULL_NODE)
+			stack.push_back(root);
+		while (!stack.empty())
+		{
+			const Node &node = nodes[stack.back()];
+			stack.pop_back();
+			if (!segment_overlaps(node.box, from, to))
+				continue;
+			if (node.is_leaf())
+			{
+				if (!callback(node.entity, node.body))
+					return;
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	size_t proxy_count() const { return leaves.size(); }
+	int height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+private:
+	static const int NULL_NODE = -1;
+
+	struct Node
+	{
+		Box box;
+		int parent = NULL_NODE; // next free node while the node is unused
+		int child1 = NULL_NODE;
+		int child2 = NULL_NODE;
+		int height = 0; // 0 for leaves, -1 for free nodes
+
+		// leaves only
+		Entity entity = Entity(0);
+		unsigned int body = 0;
+		bool is_static = false;
+
+		bool is_leaf() const { return child1 == NULL_NODE; }
+	};
+
+	std::vector<Node> nodes;
+	int root = NULL_NODE;
+	int free_list = NULL_NODE;
+	std::vector<int> stack; // scratch of the queries
+
+	ProxyTable<int> leaves; // leaf node of every proxy
+
+	static bool overlaps(const Box &a, const Box &b)
+	{
+		return a.max_x >= b.min_x && b.max_x >= a.min_x && a.max_y >= b.min_y && b.max_y >= a.min_y;
+	}
+	static bool contains(const Box &outer, const Box &inner)
+	{
+		return outer.min_x <= inner.min_x && outer.min_y <= inner.min_y && outer.max_x >= inner.max_x && outer.max_y >= inner.max_y;
+	}
+	static Box merge(const Box &a, const Box &b);
+	static float perimeter(const Box &box);
+	static bool segment_overlaps(const Box &box, vec2 from, vec2 to);
+
+	int allocate_node();
+	void free_node(int node);
+	void insert_leaf(int leaf);
+	void remove_leaf(int leaf);
+	int balance(int node);
+	void remove_proxy(unsigned int proxy);
+};
@@ -20,7 +20,7 @@ bool isWalkable(int x, int y)
 {
 	if (x >= 0 && y >= 0 && x < level_grid.size() && y < level_grid[x].size())
 	{
-		return level_grid[x][y] == 1;
+		return level_grid[x][y] == LEVEL_GRID_FLOOR;
 	}
 	return false;
 }
@@ -35,10 +35,10 @@ float attack_radius_squared = 110.f * 110.f;
 
 void AISystem::perform_chef_attack(ChefAttack attack)
 {
-	Chef &chef = registry.chef.components[0];
-	Entity chef_entity = registry.chef.entities[0];
+	Chef &chef = registry.chef.singleton();
+	Entity chef_entity = registry.chef.singleton_entity();
 	Motion &chef_motion = registry.motions.get(chef_entity);
-	Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+	Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 	vec2 player_position = player_motion.position + player_motion.bb_offset;
 	vec2 chef_position = chef_motion.position + chef_motion.bb_offset;
 	if (attack == ChefAttack::TOMATO)
@@ -72,9 +72,9 @@ void AISystem::perform_chef_attack(ChefAttack attack)
 	}
 }
 
-void AISystem::play_knight_animation(std::vector<BoneKeyframe> &keyframes)
+void AISystem::play_knight_animation(ArenaVector<BoneKeyframe> &keyframes)
 {
-	Entity knight_entity = registry.knight.entities[0];
+	Entity knight_entity = registry.knight.singleton_entity();
 
 	if (registry.boneAnimations.has(knight_entity))
 	{
@@ -89,8 +89,8 @@ void AISystem::perform_knight_attack(KnightAttack attack)
 	if (registry.knight.size() == 0 || registry.players.size() == 0)
 		return;
 
-	Knight &knight = registry.knight.components[0];
-	Entity knight_entity = registry.knight.entities[0];
+	Knight &knight = registry.knight.singleton();
+	Entity knight_entity = registry.knight.singleton_entity();
 
 	if (!registry.motions.has(knight_entity))
 		return;
@@ -121,7 +121,7 @@ void AISystem::perform_knight_attack(KnightAttack attack)
 		knight.shield_duration = 3000.f;
 		knight_motion.velocity = {0.f, 0.f};
 
-		std::vector<BoneKeyframe> keyframes = {
+		ArenaVector<BoneKeyframe> keyframes = {
 				{0.0f, 500.f, {{}, {}, {}, {}}},
 				{500.f, 2000.f, {{}, {{0.1f, 0.f}, 0.f, {1.1f, 1.1f}}, {}, {}}},
 				{2500.f, 500.f, {{}, {{0.1f, 0.f}, 0.f, {1.1f, 1.1f}}, {}, {}}},
@@ -147,9 +147,9 @@ void AISystem::perform_knight_attack(KnightAttack attack)
 	}
 }
 
-void AISystem::play_prince_animation(std::vector<BoneKeyframe> &keyframes)
+void AISystem::play_prince_animation(ArenaVector<BoneKeyframe> &keyframes)
 {
-	Entity prince_entity = registry.prince.entities[0];
+	Entity prince_entity = registry.prince.singleton_entity();
 
 	if (registry.boneAnimations.has(prince_entity))
 	{
@@ -164,7 +164,7 @@ void AISystem::perform_prince_attack(PrinceAttack attack)
 	if (registry.prince.size() == 0 || registry.players.size() == 0)
 		return;
 
-	Prince &prince = registry.prince.components[0];
+	Prince &prince = registry.prince.singleton();
 
 	prince.state = PrinceState::ATTACK;
 	prince.attack_time_elapsed = 0.f;
@@ -175,7 +175,7 @@ void AISystem::perform_prince_attack(PrinceAttack attack)
 	{
 		prince.damage_field_created = false;
 
-		std::vector<BoneKeyframe> keyframes = {
+		ArenaVector<BoneKeyframe> keyframes = {
 				{0.0f, 300.f, {{}, {}, {}, {}, {}}},
 				{300.f, 700.f, {{}, {}, {}, {{0.f, 0.f}, -5.f / 180.f * M_PI, {1.f, 1.f}}, {}}}, // pre-attack animation
 				{1000.f, 700.f, {{}, {}, {}, {{0.f, 0.f}, 30.f / 180.f * M_PI, {1.f, 1.f}}, {}}},
@@ -188,7 +188,7 @@ void AISystem::perform_prince_attack(PrinceAttack attack)
 		prince.has_teleported = false;
 		prince.has_fired = false;
 
-		Motion &prince_motion = registry.motions.get(registry.prince.entities[0]);
+		Motion &prince_motion = registry.motions.get(registry.prince.singleton_entity());
 		prince.original_scale = prince_motion.scale;
 
 		break;
@@ -197,7 +197,7 @@ void AISystem::perform_prince_attack(PrinceAttack attack)
 	{
 		prince.damage_field_created = false;
 
-		std::vector<BoneKeyframe> keyframes = {
+		ArenaVector<BoneKeyframe> keyframes = {
 				{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 				{500.f, 2000.f, {{}, {}, {}, {{0.f, 0.f}, 30.f / 180.f * M_PI, {1.f, 1.f}}, {{0.03f, -0.18f}, -30.f / 180.f * M_PI, {1.f, 1.f}}}}, // raise wand with arm
 				{2500.f, 500.f, {{}, {}, {}, {{0.f, 0.f}, 30.f / 180.f * M_PI, {1.f, 1.f}}, {{0.03f, -0.18f}, -30.f / 180.f * M_PI, {1.f, 1.f}}}},
@@ -210,7 +210,7 @@ void AISystem::perform_prince_attack(PrinceAttack attack)
 		prince.has_spirits = false;
 		prince.spirits_time_elapsed = 0.f;
 
-		std::vector<BoneKeyframe> keyframes = {
+		ArenaVector<BoneKeyframe> keyframes = {
 				{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 				{500.f, 1000.f, {{}, {{0.f, 0.05f}, 0.f, {.8f, .8f}}, {}, {}, {}}}, // retract head
 				{1500.f, 500.f, {{}, {{0.f, 0.05f}, 0.f, {.8f, .8f}}, {}, {}, {}}},
@@ -228,8 +228,8 @@ void AISystem::process_prince_attack(float elapsed_ms)
 	if (registry.prince.size() == 0 || registry.players.size() == 0)
 		return;
 
-	Prince &prince = registry.prince.components[0];
-	Entity prince_entity = registry.prince.entities[0];
+	Prince &prince = registry.prince.singleton();
+	Entity prince_entity = registry.prince.singleton_entity();
 	Motion &prince_motion = registry.motions.get(prince_entity);
 
 	if (prince.state != PrinceState::ATTACK)
@@ -263,7 +263,7 @@ void AISystem::process_prince_attack(float elapsed_ms)
 			if (t >= 1.f)
 			{
 				prince.has_teleported = true;
-				Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+				Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 				vec2 player_position = player_motion.position + player_motion.bb_offset;
 				float teleport_target_side = player_motion.position.x > prince_motion.position.x ? 1.f : -1.f;
 				prince_motion.position = player_position + vec2(teleport_target_side * (abs(prince.original_scale.x) * 0.5f + 50.f), 0.f) - prince_motion.bb_offset;
@@ -280,7 +280,7 @@ void AISystem::process_prince_attack(float elapsed_ms)
 				// TODO: replace with pulse that lasts 1000ms
 				createDamageArea(prince_entity, prince_motion.position + prince_motion.bb_offset, prince_motion.bb_scale * 1.5f, 10.f, 600.f);
 
-				std::vector<BoneKeyframe> keyframes = {
+				ArenaVector<BoneKeyframe> keyframes = {
 						{0.0f, 300.f, {{}, {}, {}, {}, {}}},
 						{300.f, 300.f, {{}, {}, {{-0.015f, -0.015f}, -30.f / 180.f * M_PI, {1.f, 1.f}}, {}, {}}}, // rotate hand
 						{600.f, 0.f, {{}, {}, {}, {}, {}}}};
@@ -352,9 +352,9 @@ void AISystem::process_prince_attack(float elapsed_ms)
 	}
 }
 
-void AISystem::play_king_animation(std::vector<BoneKeyframe> &keyframes)
+void AISystem::play_king_animation(ArenaVector<BoneKeyframe> &keyframes)
 {
-	Entity king_entity = registry.king.entities[0];
+	Entity king_entity = registry.king.singleton_entity();
 
 	if (registry.boneAnimations.has(king_entity))
 	{
@@ -369,8 +369,8 @@ void AISystem::perform_king_attack(KingAttack attack)
 	if (registry.king.size() == 0 || registry.players.size() == 0)
 		return;
 
-	King &king = registry.king.components[0];
-	Entity king_entity = registry.king.entities[0];
+	King &king = registry.king.singleton();
+	Entity king_entity = registry.king.singleton_entity();
 	Motion &king_motion = registry.motions.get(king_entity);
 
 	king.state = KingState::ATTACK;
@@ -389,7 +389,7 @@ void AISystem::perform_king_attack(KingAttack attack)
 
 		king.has_fired = false;
 
-		std::vector<BoneKeyframe> keyframes = {
+		ArenaVector<BoneKeyframe> keyframes = {
 				{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 				{500.f, 3000.f, {{}, {}, {}, {{0.f, -0.05f}, 0.f, {1.f, 1.05f}}, {}}}, // raise staff and arm
 				{3500.f, 500.f, {{}, {}, {}, {{0.f, -0.05f}, 0.f, {1.f, 1.05f}}, {}}},
@@ -442,7 +442,7 @@ void AISystem::perform_king_attack(KingAttack attack)
 		king.has_fired = false;
 		king.damage_field_created = false;
 
-		std::vector<BoneKeyframe> keyframes = {
+		ArenaVector<BoneKeyframe> keyframes = {
 				{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 				{500.f, 3000.f, {{}, {{0.f, 0.05f}, 0.f, {1.2f, 1.2f}}, {}, {{0.f, -0.05f}, 0.f, {1.f, 1.05f}}, {}}}, // raise staff and arm, enlarge head
 				{3500.f, 500.f, {{}, {{0.f, 0.05f}, 0.f, {1.2f, 1.2f}}, {}, {{0.f, -0.05f}, 0.f, {1.f, 1.05f}}, {}}},
@@ -520,8 +520,8 @@ void AISystem::process_king_attack(float elapsed_ms)
 	if (registry.king.size() == 0 || registry.players.size() == 0)
 		return;
 
-	King &king = registry.king.components[0];
-	Entity king_entity = registry.king.entities[0];
+	King &king = registry.king.singleton();
+	Entity king_entity = registry.king.singleton_entity();
 	Motion &king_motion = registry.motions.get(king_entity);
 
 	if (king.state != KingState::ATTACK)
@@ -573,18 +573,18 @@ void AISystem::process_king_attack(float elapsed_ms)
 					float laser_length = laser_motion.bb_scale.x;
 					vec2 laser_end = {laser_start.x + cos(angle) * laser_length, laser_start.y + sin(angle) * laser_length};
 
-					Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+					Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 					vec2 player_position = player_motion.position + player_motion.bb_offset;
 					vec2 player_bb = player_motion.bb_scale / 2.f;
 
 					// check laser line intersection with the two diagonals of the player bounding box
 					if (line_intersects(laser_start, laser_end, player_position - player_bb, player_position + player_bb) || line_intersects(laser_start, laser_end, player_position + vec2(-player_bb.x, player_bb.y), player_position + vec2(player_bb.x, -player_bb.y)))
 					{
-						Player &player = registry.players.get(registry.players.entities[0]);
+						Player &player = registry.players.get(registry.players.singleton_entity());
 						if (player.can_take_damage())
 						{
 							std::cout << "Laser hit player for 10 damage" << std::endl;
-							Health &player_health = registry.healths.get(registry.players.entities[0]);
+							Health &player_health = registry.healths.get(registry.players.singleton_entity());
 							player_health.take_damage(10.f);
 							king.laser_damage_cooldown = 500.f;
 						}
@@ -600,7 +600,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 	}
 	case KingAttack::DASH_HIT:
 	{
-		Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+		Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 		vec2 player_position = player_motion.position + player_motion.bb_offset;
 		vec2 king_position = king_motion.position + king_motion.bb_offset;
 		if (king.attack_time_elapsed >= 2000.f * (float)king.dash_counter)
@@ -626,7 +626,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 			// after 1s dash, hit with staff for 1s
 			king_motion.velocity = {0.f, 0.f};
 
-			std::vector<BoneKeyframe> keyframes = {
+			ArenaVector<BoneKeyframe> keyframes = {
 					{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 					{500.f, 500.f, {{}, {}, {}, {{0.03f, 0.02f}, 30.f / 180.f * M_PI, {1.f, 1.f}}, {}}}, // rotate arm with staff
 					{1000.f, 0.f, {{}, {}, {}, {}, {}}}};
@@ -653,7 +653,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 		if (!king.has_fired && king.attack_time_elapsed >= 500.f)
 		{
 			king.has_fired = true;
-			Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+			Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 			king.fire_rain_entity = createFireRain(renderer, player_motion.position + player_motion.bb_offset);
 
 			registry.opacities.insert(king.fire_rain_entity, 0.2f);
@@ -694,7 +694,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 	}
 	case KingAttack::TRIPLE_DASH:
 	{
-		Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+		Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 		vec2 player_position = player_motion.position + player_motion.bb_offset;
 		vec2 king_position = king_motion.position + king_motion.bb_offset;
 		if (king.attack_time_elapsed >= 1500.f * (float)king.dash_counter)
@@ -711,7 +711,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 				break;
 			}
 
-			std::vector<BoneKeyframe> keyframes = {
+			ArenaVector<BoneKeyframe> keyframes = {
 					{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 					{500.f, 400.f, {{}, {{0.f, 0.05f}, 0.f, {.8f, .8f}}, {}, {}, {{0.f, 0.f}, 0.f, {.8f, .8f}}}}, // retract head and feet
 					{900.f, 100.f, {{}, {{0.f, 0.05f}, 0.f, {.8f, .8f}}, {}, {}, {{0.f, 0.f}, 0.f, {.8f, .8f}}}}, // retract head and feet
@@ -738,7 +738,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 			king.has_teleported = true;
 			king.is_invincible = false;
 
-			Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+			Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 			vec2 player_position = player_motion.position + player_motion.bb_offset;
 			float teleport_target_side = player_motion.position.x > king_motion.position.x ? 1.f : -1.f;
 			king_motion.position = player_position + vec2(teleport_target_side * (abs(king_motion.bb_scale.x) * 0.5f + 50.f), 0.f) - king_motion.bb_offset;
@@ -756,7 +756,7 @@ void AISystem::process_king_attack(float elapsed_ms)
 			}
 
 			// play staff animation
-			std::vector<BoneKeyframe> keyframes = {
+			ArenaVector<BoneKeyframe> keyframes = {
 					{0.0f, 500.f, {{}, {}, {}, {}, {}}},
 					{500.f, 500.f, {{}, {}, {}, {{0.03f, 0.02f}, 30.f / 180.f * M_PI, {1.f, 1.f}}, {}}}, // rotate arm with staff
 					{1000.f, 0.f, {{}, {}, {}, {}, {}}}};
@@ -791,7 +791,7 @@ DecisionNode *AISystem::create_chef_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				return chef.state == ChefState::PATROL;
 			});
 
@@ -801,10 +801,10 @@ DecisionNode *AISystem::create_chef_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Entity &entity = registry.chef.entities[0];
+				Entity entity = registry.chef.singleton_entity();
 				Motion &motion = registry.motions.get(entity);
 
-				Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+				Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 				vec2 player_position = player_motion.position + player_motion.bb_offset;
 				vec2 chef_position = motion.position + motion.bb_offset;
 				return distance_squared(player_position, chef_position) < 330.f * 330.f;
@@ -815,8 +815,8 @@ DecisionNode *AISystem::create_chef_decision_tree()
 			[](float)
 			{
 				std::cout << "Chef enters combat" << std::endl;
-				Chef &chef = registry.chef.components[0];
-				Motion &motion = registry.motions.get(registry.chef.entities[0]);
+				Chef &chef = registry.chef.singleton();
+				Motion &motion = registry.motions.get(registry.chef.singleton_entity());
 				chef.state = ChefState::COMBAT;
 				chef.trigger = true;
 				chef.sound_trigger_timer = 1200.f;
@@ -828,12 +828,12 @@ DecisionNode *AISystem::create_chef_decision_tree()
 	DecisionNode *patrol_time = new DecisionNode(
 			[](float elapsed_ms)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				chef.time_since_last_patrol += elapsed_ms;
 			},
 			[](float)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				return chef.time_since_last_patrol > 2000.f;
 			});
 	patrol_node->falseBranch = patrol_time;
@@ -842,8 +842,8 @@ DecisionNode *AISystem::create_chef_decision_tree()
 			[](float)
 			{
 				// std::cout << "Chef is patrolling" << std::endl;
-				Chef &chef = registry.chef.components[0];
-				Entity &entity = registry.chef.entities[0];
+				Chef &chef = registry.chef.singleton();
+				Entity entity = registry.chef.singleton_entity();
 				Motion &motion = registry.motions.get(entity);
 				motion.velocity.x *= -1;
 				chef.time_since_last_patrol = 0.f;
@@ -857,7 +857,7 @@ DecisionNode *AISystem::create_chef_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				return chef.state == ChefState::COMBAT;
 			});
 	chef_decision_tree->falseBranch = combat_state_check;
@@ -865,17 +865,17 @@ DecisionNode *AISystem::create_chef_decision_tree()
 	DecisionNode *combat_node = new DecisionNode(
 			[](float elapsed_ms)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				chef.time_since_last_attack += elapsed_ms;
 				if (chef.time_since_last_attack > 1500.f)
 				{
-					Motion &motion = registry.motions.get(registry.chef.entities[0]);
+					Motion &motion = registry.motions.get(registry.chef.singleton_entity());
 					motion.velocity = {0.f, 0.f};
 				}
 			},
 			[](float)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				return chef.time_since_last_attack > 3000.f;
 			});
 	combat_state_check->trueBranch = combat_node;
@@ -883,7 +883,7 @@ DecisionNode *AISystem::create_chef_decision_tree()
 	DecisionNode *initiate_attack = new DecisionNode(
 			[](float)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				chef.state = ChefState::ATTACK;
 			},
 			nullptr);
@@ -892,12 +892,12 @@ DecisionNode *AISystem::create_chef_decision_tree()
 	DecisionNode *attack_node = new DecisionNode(
 			[this](float)
 			{
-				Chef &chef = registry.chef.components[0];
+				Chef &chef = registry.chef.singleton();
 				std::cout << "Chef attacks " << (int)chef.current_attack << std::endl;
 
 				this->perform_chef_attack(chef.current_attack);
 				// set is attacking to true
-				auto &bossAnimation = registry.bossAnimations.get(registry.chef.entities[0]);
+				auto &bossAnimation = registry.bossAnimations.get(registry.chef.singleton_entity());
 				bossAnimation.is_attacking = true;
 				bossAnimation.elapsed_time = 0.f;
 				bossAnimation.attack_id = static_cast<int>(chef.current_attack); // Cast to int
@@ -927,7 +927,7 @@ DecisionNode *AISystem::create_knight_decision_tree()
 				if (registry.knight.size() == 0)
 					return false;
 
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 				return knight.state == KnightState::PATROL;
 			});
 
@@ -936,10 +936,10 @@ DecisionNode *AISystem::create_knight_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Entity &entity = registry.knight.entities[0];
+				Entity entity = registry.knight.singleton_entity();
 				Motion &motion = registry.motions.get(entity);
 
-				Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+				Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 				vec2 player_position = player_motion.position + player_motion.bb_offset;
 				vec2 knight_position = motion.position + motion.bb_offset;
 				return distance_squared(player_position, knight_position) < detection_radius_squared;
@@ -950,8 +950,8 @@ DecisionNode *AISystem::create_knight_decision_tree()
 			[](float)
 			{
 				std::cout << "Knight enters combat" << std::endl;
-				Knight &knight = registry.knight.components[0];
-				Motion &motion = registry.motions.get(registry.knight.entities[0]);
+				Knight &knight = registry.knight.singleton();
+				Motion &motion = registry.motions.get(registry.knight.singleton_entity());
 				knight.state = KnightState::COMBAT;
 				motion.velocity = {0.f, 0.f};
 			},
@@ -961,12 +961,12 @@ DecisionNode *AISystem::create_knight_decision_tree()
 	DecisionNode *patrol_time = new DecisionNode(
 			[](float elapsed_ms)
 			{
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 				knight.time_since_last_patrol += elapsed_ms;
 			},
 			[](float)
 			{
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 				return knight.time_since_last_patrol > 2000.f;
 			});
 	patrol_node->falseBranch = patrol_time;
@@ -974,8 +974,8 @@ DecisionNode *AISystem::create_knight_decision_tree()
 	DecisionNode *change_patrol_direction = new DecisionNode(
 			[](float)
 			{
-				Knight &knight = registry.knight.components[0];
-				Entity &entity = registry.knight.entities[0];
+				Knight &knight = registry.knight.singleton();
+				Entity entity = registry.knight.singleton_entity();
 				Motion &motion = registry.motions.get(entity);
 				if (motion.velocity.x == 0)
 				{
@@ -995,7 +995,7 @@ DecisionNode *AISystem::create_knight_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 				return knight.state == KnightState::COMBAT;
 			});
 	knight_decision_tree->falseBranch = combat_state_check;
@@ -1003,12 +1003,12 @@ DecisionNode *AISystem::create_knight_decision_tree()
 	DecisionNode *combat_cooldown = new DecisionNode(
 			[](float elapsed_ms)
 			{
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 				knight.combat_cooldown -= elapsed_ms;
 			},
 			[](float)
 			{
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 				return knight.combat_cooldown <= 0.f;
 			});
 	combat_state_check->trueBranch = combat_cooldown;
@@ -1016,7 +1016,7 @@ DecisionNode *AISystem::create_knight_decision_tree()
 	DecisionNode *attack_selection = new DecisionNode(
 			[this](float)
 			{
-				Knight &knight = registry.knight.components[0];
+				Knight &knight = registry.knight.singleton();
 
 				// Randomly select an attack
 				int random_attack = rand() % 3;
@@ -1042,7 +1042,7 @@ DecisionNode *AISystem::create_prince_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Prince &prince = registry.prince.components[0];
+				Prince &prince = registry.prince.singleton();
 				return prince.state != PrinceState::IDLE;
 			});
 
@@ -1050,7 +1050,7 @@ DecisionNode *AISystem::create_prince_decision_tree()
 			nullptr,
 			[](float)
 			{
-				Prince &prince = registry.prince.components[0];
+				Prince &prince = registry.prince.singleton();
 				return prince.state == PrinceState::COMBAT;
 			});
 	prince_decision_tree->trueBranch = combat_state_check;
@@ -1058,12 +1058,12 @@ DecisionNode *AISystem::create_prince_decision_tree()
 	DecisionNode *combat_cooldown = new DecisionNode(
 			[](float elapsed_ms)
 			{
-				Prince &prince = registry.prince.components[0];
+				Prince &prince = registry.prince.singleton();
 				prince.combat_cooldown -= elapsed_ms;
 			},
 			[](float)
 			{
-				Prince &prince = registry.prince.components[0];
+				Prince &prince = registry.prince.singleton();
 				return prince.combat_cooldown <= 0.f;
 			});
 	combat_state_check->trueBranch = combat_cooldown;
@@ -1071,9 +1071,9 @@ DecisionNode *AISystem::create_prince_decision_tree()
 	DecisionNode *attack_selection = new DecisionNode(
 			[this](float)
 			{
-				Prince &prince = registry.prince.components[0];
+				Prince &prince = registry.prince.singleton();
 
-				Health &prince_health = registry.healths.get(registry.prince.entities[0]);
+				Health &prince_health = registry.healths.get(registry.prince.singleton_entity());
 				float health_percentage = prince_health.health / prince_health.max_health;
 				if ((health_percentage < 0.66f && prince.health_percentage >= 0.66f) || (health_percentage < 0.33f && prince.health_percentage >= 0.33f))
 				{
@@ -1107,13 +1107,13 @@ DecisionNode *AISystem::create_prince_decision_tree()
 	DecisionNode *idle_processing = new DecisionNode(
 			[](float)
 			{
-				Motion &prince_motion = registry.motions.get(registry.prince.entities[0]);
-				Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+				Motion &prince_motion = registry.motions.get(registry.prince.singleton_entity());
+				Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 				vec2 player_position = player_motion.position + player_motion.bb_offset;
 				vec2 prince_position = prince_motion.position + prince_motion.bb_offset;
 				if (distance_squared(player_position, prince_position) < detection_radius_squared)
 				{
-					Prince &prince = registry.prince.components[0];
+					Prince &prince = registry.prince.singleton();
 					prince.state = PrinceState::COMBAT;
 				}
 			},
@@ -1129,7 +1129,7 @@ DecisionNode *AISystem::create_king_decision_tree()
 			nullptr,
 			[](float)
 			{
-				King &king = registry.king.components[0];
+				King &king = registry.king.singleton();
 				return king.state != KingState::IDLE;
 			});
 
@@ -1137,7 +1137,7 @@ DecisionNode *AISystem::create_king_decision_tree()
 			nullptr,
 			[](float)
 			{
-				King &king = registry.king.components[0];
+				King &king = registry.king.singleton();
 				return king.state == KingState::COMBAT;
 			});
 	king_decision_tree->trueBranch = combat_state_check;
@@ -1145,12 +1145,12 @@ DecisionNode *AISystem::create_king_decision_tree()
 	DecisionNode *combat_cooldown = new DecisionNode(
 			[](float elapsed_ms)
 			{
-				King &king = registry.king.components[0];
+				King &king = registry.king.singleton();
 				king.combat_cooldown -= elapsed_ms;
 			},
 			[](float)
 			{
-				King &king = registry.king.components[0];
+				King &king = registry.king.singleton();
 				return king.combat_cooldown <= 0.f;
 			});
 	combat_state_check->trueBranch = combat_cooldown;
@@ -1158,11 +1158,11 @@ DecisionNode *AISystem::create_king_decision_tree()
 	DecisionNode *attack_selection = new DecisionNode(
 			[this](float)
 			{
-				King &king = registry.king.components[0];
+				King &king = registry.king.singleton();
 
 				if (king.is_second_stage)
 				{
-					Health &king_health = registry.healths.get(registry.king.entities[0]);
+					Health &king_health = registry.healths.get(registry.king.singleton_entity());
 					float health_percentage = king_health.health / king_health.max_health;
 					if ((health_percentage < 0.66f && king.health_percentage >= 0.66f) || (health_percentage < 0.33f && king.health_percentage >= 0.33f))
 					{
@@ -1199,13 +1199,13 @@ DecisionNode *AISystem::create_king_decision_tree()
 	DecisionNode *idle_processing = new DecisionNode(
 			[](float)
 			{
-				Motion &king_motion = registry.motions.get(registry.king.entities[0]);
-				Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+				Motion &king_motion = registry.motions.get(registry.king.singleton_entity());
+				Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 				vec2 player_position = player_motion.position + player_motion.bb_offset;
 				vec2 king_position = king_motion.position + king_motion.bb_offset;
 				if (distance_squared(player_position, king_position) < detection_radius_squared)
 				{
-					King &king = registry.king.components[0];
+					King &king = registry.king.singleton();
 					king.state = KingState::COMBAT;
 				}
 			},
@@ -1236,47 +1236,29 @@ void AISystem::init(RenderSystem *renderer)
 	this->renderer = renderer;
 }
 
-void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
+void AISystem::gather_minion_target()
 {
-	Entity player = registry.players.entities[0];
+	Entity player = registry.players.singleton_entity();
 	assert(player);
 
 	Player &player_comp = registry.players.get(player);
-	if (player_comp.state == PlayerState::DYING || player_comp.stealth_mode)
-	{
-		// skip all ai processing if player is dead (or in stealth mode); also make enemies stop moving/attacking
-		ComponentContainer<Enemy> &enemies = registry.enemies;
-		for (uint i = 0; i < enemies.components.size(); i++)
-		{
-			Enemy &enemy = enemies.components[i];
-			Entity entity = enemies.entities[i];
-			Motion &motion = registry.motions.get(entity);
-			motion.velocity = {0.f, 0.f};
-			if (registry.spriteAnimations.has(entity))
-			{
-				auto &animation = registry.spriteAnimations.get(entity);
-				auto &render_request = registry.renderRequests.get(entity);
-				animation.current_frame = 0;
-				render_request.used_texture = animation.frames[animation.current_frame];
-				registry.spriteAnimations.remove(entity);
-			}
-			enemy.state = EnemyState::IDLE;
-		}
-		return;
-	}
+	// step() stops every enemy while the player is dying or hidden
+	minions_active = !(player_comp.state == PlayerState::DYING || player_comp.stealth_mode);
 
 	Motion &player_motion = registry.motions.get(player);
-	vec2 player_position = player_motion.position + player_motion.bb_offset;
-	ComponentContainer<Enemy> &enemies = registry.enemies;
-	for (uint i = 0; i < enemies.components.size(); i++)
-	{
-		Enemy &enemy = enemies.components[i];
-		Entity entity = enemies.entities[i];
+	minion_target = player_motion.position + player_motion.bb_offset;
+}
 
-		if (registry.chef.has(entity) || registry.knight.has(entity) || registry.prince.has(entity) || registry.king.has(entity)) // Skip all bosses
-		{
-			continue;
-		}
+void AISystem::step_minions(float elapsed_ms)
+{
+	if (!minions_active)
+		return;
+
+	vec2 player_position = minion_target;
+	// Bosses have their own decision trees in step(), dead minions stay where they fell
+	for (Entity entity : registry.live_minions.entities())
+	{
+		Enemy &enemy = registry.enemies.get(entity);
 
 		Motion &motion = registry.motions.get(entity);
 		vec2 enemy_position = motion.position + motion.bb_offset;
@@ -1300,7 +1282,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
                 if (distance_to_player < detection_radius_squared)
                 {
                     enemy.state = EnemyState::COMBAT;
-                    std::cout << "Ranged Enemy " << i << " enters combat" << std::endl;
+                    std::cout << "Ranged Enemy " << entity << " enters combat" << std::endl;
                 }
             }
             else if (enemy.state == EnemyState::COMBAT)
@@ -1309,7 +1291,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
                 {
                     enemy.state = EnemyState::IDLE;
                     motion.velocity = {0.f, 0.f};
-                    std::cout << "Ranged Enemy " << i << " enters idle" << std::endl;
+                    std::cout << "Ranged Enemy " << entity << " enters idle" << std::endl;
                 }
                 else if (distance_to_player > rangedMinion.attack_radius_squared)
                 {
@@ -1336,7 +1318,9 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
                     {
                         // Shoot arrow
                         vec2 arrow_velocity = normalize(player_position - enemy_position) * rangedMinion.arrow_speed;
-                        createArrow(renderer, enemy_position, arrow_velocity);
+                        RenderSystem *renderer = this->renderer;
+                        pending_spawns.push_back([renderer, enemy_position, arrow_velocity]()
+                                                 { createArrow(renderer, enemy_position, arrow_velocity); });
 
                         enemy.time_since_last_attack = 0.f;
 
@@ -1365,7 +1349,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 			if (distance_to_player < detection_radius_squared)
 			{
 				enemy.state = EnemyState::COMBAT;
-				std::cout << "Enemy " << i << " enters combat" << std::endl;
+				std::cout << "Enemy " << entity << " enters combat" << std::endl;
 			}
 		}
 		else if (enemy.state == EnemyState::COMBAT)
@@ -1374,7 +1358,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 			{
 				enemy.state = EnemyState::IDLE;
 				motion.velocity = {0.f, 0.f};
-				std::cout << "Enemy " << i << " returns to idle" << std::endl;
+				std::cout << "Enemy " << entity << " returns to idle" << std::endl;
 			}
 			else
 			{
@@ -1390,14 +1374,15 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 				// }
 				// return;
 
-				std::vector<vec2> path = findPathAStar(adjusted_position, player_position);
+				ArenaVector<vec2> path = findPathAStar(adjusted_position, player_position);
 
 				if (debugging.in_debug_mode)
 				{
 					for (int i = 0; i < path.size(); i++)
 					{
 						vec2 path_point = path[i];
-						createLine(path_point, {10.f, 10.f}, {1.f, 0.f, 0.f}, 0.f);
+						pending_spawns.push_back([path_point]()
+																		 { createLine(path_point, {10.f, 10.f}, {1.f, 0.f, 0.f}, 0.f); });
 					}
 				}
 
@@ -1442,7 +1427,9 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 
 						enemy.time_since_last_attack = 0.f;
 
-						createDamageArea(entity, motion.position, {100.f, 70.f}, 7.f, 500.f, 0.f, true, {50.f, 50.f});
+						vec2 attack_position = motion.position;
+						pending_spawns.push_back([entity, attack_position]()
+																		 { createDamageArea(entity, attack_position, {100.f, 70.f}, 7.f, 500.f, 0.f, true, {50.f, 50.f}); });
 					}
 				}
 			}
@@ -1477,12 +1464,45 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 		}
 		}
 	}
+}
+
+void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
+{
+	// entities the minions asked for during step_minions
+	for (std::function<void()> &spawn : pending_spawns)
+		spawn();
+	pending_spawns.clear();
+
+	Entity player = registry.players.singleton_entity();
+	assert(player);
 
+	Player &player_comp = registry.players.get(player);
+	if (player_comp.state == PlayerState::DYING || player_comp.stealth_mode)
+	{
+		// skip all ai processing if player is dead (or in stealth mode); also make enemies stop moving/attacking
+		// corpses keep their corpse texture
+		for (Entity entity : registry.live_enemies.entities())
+		{
+			Enemy &enemy = registry.enemies.get(entity);
+			Motion &motion = registry.motions.get(entity);
+			motion.velocity = {0.f, 0.f};
+			if (registry.spriteAnimations.has(entity))
+			{
+				auto &animation = registry.spriteAnimations.get(entity);
+				auto &render_request = registry.renderRequests.get(entity);
+				animation.current_frame = 0;
+				render_request.used_texture = animation.frames[animation.current_frame];
+				registry.spriteAnimations.remove(entity);
+			}
+			enemy.state = EnemyState::IDLE;
+		}
+		return;
+	}
 
 	if (registry.chef.size() > 0)
 	{
 		// special behavior for chef
-		Entity chef_entity = registry.chef.entities[0];
+		Entity chef_entity = registry.chef.singleton_entity();
 		Health &chef_health = registry.healths.get(chef_entity);
 		if (!chef_health.is_dead)
 		{
@@ -1499,7 +1519,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 
 	if (registry.knight.size() > 0)
 	{
-		Entity knight_entity = registry.knight.entities[0];
+		Entity knight_entity = registry.knight.singleton_entity();
 		Health &knight_health = registry.healths.get(knight_entity);
 		if (!knight_health.is_dead)
 		{
@@ -1507,7 +1527,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 			Knight &knight = registry.knight.get(knight_entity);
 
 			Motion &knight_motion = registry.motions.get(knight_entity);
-			Motion &player_motion = registry.motions.get(registry.players.entities[0]);
+			Motion &player_motion = registry.motions.get(registry.players.singleton_entity());
 			vec2 player_position = player_motion.position + player_motion.bb_offset;
 			vec2 knight_position = knight_motion.position + knight_motion.bb_offset;
 
@@ -1554,7 +1574,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 					}
 
 					// Start dash animation
-					std::vector<BoneKeyframe> keyframes = {
+					ArenaVector<BoneKeyframe> keyframes = {
 							{0.0f, 250.f, {{}, {}, {}, {}}},
 							{250.f, 500.f, {{}, {}, {{0.f, 0.f}, angle_to_player, {1.f, 1.f}}, {}}},
 							{750.f, 250.f, {{}, {}, {{0.f, 0.f}, angle_to_player, {1.f, 1.f}}, {}}},
@@ -1567,7 +1587,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 					knight_motion.velocity = {0.f, 0.f};
 
 					// Start attack animation
-					std::vector<BoneKeyframe> keyframes = {
+					ArenaVector<BoneKeyframe> keyframes = {
 							{0.0f, 500.f, {{}, {}, {}, {}}},
 							{500.f, 500.f, {{}, {}, {}, {{-0.08f, 0.1f}, -45.f / 180.f * M_PI, {1.f, 1.f}}}},
 							{1000.f, 0.f, {{}, {}, {}, {}}}};
@@ -1593,7 +1613,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 						knight.damage_field_active = false;
 
 						// Start damage field animation
-						std::vector<BoneKeyframe> keyframes = {
+						ArenaVector<BoneKeyframe> keyframes = {
 								{0.0f, 500.f, {{}, {}, {}, {}}},
 								{500.f, 3000.f, {{}, {}, {}, {{0.f, 0.2f}, 0.f, {1.f, 1.1f}}}},
 								{3500.f, 500.f, {{}, {}, {}, {{0.f, 0.2f}, 0.f, {1.f, 1.1f}}}},
@@ -1608,7 +1628,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 						knight.dash_count++;
 
 						// Start dash-attack animation
-						std::vector<BoneKeyframe> keyframes = {
+						ArenaVector<BoneKeyframe> keyframes = {
 								{0.0f, 750.f, {{}, {}, {}, {}}},
 								{750.f, 750.f, {{}, {}, {}, {{-0.12f, -0.14f}, 45.f / 180.f * M_PI, {1.f, 1.f}}}},
 								{1500.f, 0.f, {{}, {}, {}, {}}}};
@@ -1654,7 +1674,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 
 	if (registry.prince.size() > 0)
 	{
-		Entity prince_entity = registry.prince.entities[0];
+		Entity prince_entity = registry.prince.singleton_entity();
 		Health &prince_health = registry.healths.get(prince_entity);
 		if (!prince_health.is_dead)
 		{
@@ -1664,7 +1684,7 @@ void AISystem::step(float elapsed_ms, std::vector<std::vector<int>> &levelMap)
 
 	if (registry.king.size() > 0)
 	{
-		Entity king_entity = registry.king.entities[0];
+		Entity king_entity = registry.king.singleton_entity();
 		Health &king_health = registry.healths.get(king_entity);
 		if (!king_health.is_dead)
 		{
@@ -1680,7 +1700,7 @@ void AISystem::boss_attack(Entity entity, int attack_id, float elapsed_ms)
 	auto &render_request = registry.renderRequests.get(entity);
 	bossAnimation.elapsed_time += elapsed_ms;
 
-	std::vector<TEXTURE_ASSET_ID> &frames = bossAnimation.attack_1;
+	ArenaVector<TEXTURE_ASSET_ID> &frames = bossAnimation.attack_1;
 	// get motion
 	auto &motion = registry.motions.get(entity);
 
@@ -1742,7 +1762,7 @@ int nodeKey(int x, int y, int maxHeight)
 	return x * maxHeight + y;
 }
 
-std::vector<vec2> AISystem::findPathAStar(vec2 startPos, vec2 goalPos)
+ArenaVector<vec2> AISystem::findPathAStar(vec2 startPos, vec2 goalPos)
 {
 	const int TILE_SIZE = 60;
 	int startX = static_cast<int>(startPos.x / TILE_SIZE);
@@ -1803,7 +1823,7 @@ std::vector<vec2> AISystem::findPathAStar(vec2 startPos, vec2 goalPos)
 		if (current->x == goalX && current->y == goalY)
 		{
 			// Reconstruct path
-			std::vector<vec2> path;
+			ArenaVector<vec2> path;
 			AStarNode *node = current;
 			while (node != nullptr)
 			{
@@ -59,6 +59,11 @@ public:
     ~AISystem();
     void init(RenderSystem *renderer);
     void step(float elapsed_ms, std::vector<std::vector<int>> &levelMap);
+    // Minion behaviour, runs as its own scheduler task before step(). It only touches the minions'
+    // Enemy, Motion and RenderRequest; the player is read in gather_minion_target beforehand and
+    // the arrows and damage areas it fires are created at the start of step().
+    void gather_minion_target();
+    void step_minions(float elapsed_ms);
     void boss_attack(Entity entity, int attack_id, float elapsed_ms);
     // struct Node
     // {
@@ -73,11 +78,15 @@ public:
     // 	}
     // };
 
-    std::vector<vec2> findPathAStar(vec2 start, vec2 goal);
+    ArenaVector<vec2> findPathAStar(vec2 start, vec2 goal);
 
 private:
     RenderSystem *renderer;
 
+    bool minions_active = false;
+    vec2 minion_target = {0.f, 0.f}; // player position the minions chase this step
+    std::vector<std::function<void()>> pending_spawns;
+
     DecisionNode *chef_decision_tree;
     DecisionNode *knight_decision_tree;
     DecisionNode *prince_decision_tree;
@@ -92,9 +101,9 @@ private:
     void process_prince_attack(float elapsed_ms);
     void perform_king_attack(KingAttack attack);
     void process_king_attack(float elapsed_ms);
-    void play_knight_animation(std::vector<BoneKeyframe> &keyframes);
-    void play_prince_animation(std::vector<BoneKeyframe> &keyframes);
-    void play_king_animation(std::vector<BoneKeyframe> &keyframes);
+    void play_knight_animation(ArenaVector<BoneKeyframe> &keyframes);
+    void play_prince_animation(ArenaVector<BoneKeyframe> &keyframes);
+    void play_king_animation(ArenaVector<BoneKeyframe> &keyframes);
 
     // bool isWalkable(int x, int y, const std::vector<std::vector<int>>& grid);
     // std::vector<Node> findPathBFS(int startX, int startY, int targetX, int targetY, const std::vector<std::vector<int>>& grid);
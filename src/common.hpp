@@ -35,6 +35,11 @@ const int window_height_px = 720;
 
 const float TILE_SCALE = 60.f;
 
+// The simulation advances in fixed steps, rendering interpolates between the last two of them
+const float FIXED_STEP_MS = 1000.f / 60.f;
+// Catch-up cap: after a longer hitch the game slows down instead of running ever more steps
+const int MAX_STEPS_PER_FRAME = 5;
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
@@ -0,0 +1,136 @@
+// internal
+#include "component_snapshot.hpp"
+
+void write_component(SnapshotBuffer &buffer, const Enemy &enemy)
+{
+	buffer.write_value(enemy.state);
+	buffer.write_value(enemy.time_since_last_attack);
+	buffer.write_value(enemy.attack_countdown);
+	buffer.write_value(enemy.attack_damage);
+	buffer.write_value(enemy.last_hit_attack_id);
+	buffer.write_value(enemy.is_minion);
+	buffer.write_vector(enemy.path);
+	buffer.write_value(enemy.current_path_index);
+	buffer.write_value(enemy.pathfinding_counter);
+	buffer.write_value(enemy.last_tile_position);
+}
+
+void read_component(SnapshotBuffer &buffer, Enemy &enemy)
+{
+	buffer.read_value(enemy.state);
+	buffer.read_value(enemy.time_since_last_attack);
+	buffer.read_value(enemy.attack_countdown);
+	buffer.read_value(enemy.attack_damage);
+	buffer.read_value(enemy.last_hit_attack_id);
+	buffer.read_value(enemy.is_minion);
+	buffer.read_vector(enemy.path);
+	buffer.read_value(enemy.current_path_index);
+	buffer.read_value(enemy.pathfinding_counter);
+	buffer.read_value(enemy.last_tile_position);
+}
+
+void write_component(SnapshotBuffer &buffer, const SpriteAnimation &animation)
+{
+	buffer.write_vector(animation.frames);
+	buffer.write_value(animation.current_frame);
+	buffer.write_value(animation.frame_duration);
+	buffer.write_value(animation.elapsed_time);
+	buffer.write_value(animation.isattacking);
+}
+
+void read_component(SnapshotBuffer &buffer, SpriteAnimation &animation)
+{
+	buffer.read_vector(animation.frames);
+	buffer.read_value(animation.current_frame);
+	buffer.read_value(animation.frame_duration);
+	buffer.read_value(animation.elapsed_time);
+	buffer.read_value(animation.isattacking);
+}
+
+void write_component(SnapshotBuffer &buffer, const BossAnimation &animation)
+{
+	buffer.write_vector(animation.attack_1);
+	buffer.write_vector(animation.attack_2);
+	buffer.write_vector(animation.attack_3);
+	buffer.write_vector(animation.attack_4);
+	buffer.write_vector(animation.attack_5);
+	buffer.write_value(animation.current_frame);
+	buffer.write_value(animation.frame_duration);
+	buffer.write_value(animation.elapsed_time);
+	buffer.write_value(animation.is_attacking);
+	buffer.write_value(animation.attack_id);
+}
+
+void read_component(SnapshotBuffer &buffer, BossAnimation &animation)
+{
+	buffer.read_vector(animation.attack_1);
+	buffer.read_vector(animation.attack_2);
+	buffer.read_vector(animation.attack_3);
+	buffer.read_vector(animation.attack_4);
+	buffer.read_vector(animation.attack_5);
+	buffer.read_value(animation.current_frame);
+	buffer.read_value(animation.frame_duration);
+	buffer.read_value(animation.elapsed_time);
+	buffer.read_value(animation.is_attacking);
+	buffer.read_value(animation.attack_id);
+}
+
+void write_component(SnapshotBuffer &buffer, const TreasureBox &treasure_box)
+{
+	buffer.write_value(treasure_box.is_open);
+	buffer.write_value(treasure_box.item);
+	buffer.write_value(treasure_box.weapon_level);
+	buffer.write_value(treasure_box.weapon_type);
+	buffer.write_value(treasure_box.item_entity);
+	buffer.write_vector(treasure_box.associated_minions);
+}
+
+void read_component(SnapshotBuffer &buffer, TreasureBox &treasure_box)
+{
+	buffer.read_value(treasure_box.is_open);
+	buffer.read_value(treasure_box.item);
+	buffer.read_value(treasure_box.weapon_level);
+	buffer.read_value(treasure_box.weapon_type);
+	buffer.read_value(treasure_box.item_entity);
+	buffer.read_vector(treasure_box.associated_minions);
+}
+
+void write_component(SnapshotBuffer &buffer, const BoneAnimation &animation)
+{
+	buffer.write_value((uint64_t)animation.keyframes.size());
+	for (const BoneKeyframe &keyframe : animation.keyframes)
+	{
+		buffer.write_value(keyframe.start_time);
+		buffer.write_value(keyframe.duration);
+		buffer.write_vector(keyframe.bone_transforms);
+	}
+	buffer.write_value(animation.current_keyframe);
+	buffer.write_value(animation.loop);
+	buffer.write_value(animation.elapsed_time);
+}
+
+void read_component(SnapshotBuffer &buffer, BoneAnimation &animation)
+{
+	uint64_t keyframe_count;
+	buffer.read_value(keyframe_count);
+	animation.keyframes.resize((size_t)keyframe_count);
+	for (BoneKeyframe &keyframe : animation.keyframes)
+	{
+		buffer.read_value(keyframe.start_time);
+		buffer.read_value(keyframe.duration);
+		buffer.read_vector(keyframe.bone_transforms);
+	}
+	buffer.read_value(animation.current_keyframe);
+	buffer.read_value(animation.loop);
+	buffer.read_value(animation.elapsed_time);
+}
+
+void write_component(SnapshotBuffer &buffer, const MeshBones &mesh_bones)
+{
+	buffer.write_vector(mesh_bones.bones);
+}
+
+void read_component(SnapshotBuffer &buffer, MeshBones &mesh_bones)
+{
+	buffer.read_vector(mesh_bones.bones);
+}
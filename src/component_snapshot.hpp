@@ -0,0 +1,50 @@
+#pragma once
+
+#include "tiny_ecs.hpp"
+#include "components.hpp"
+
+// Snapshot hooks for components that own vectors and therefore cannot be copied as raw bytes.
+// Every other component is serialized as one block by the default SnapshotSerializer.
+
+void write_component(SnapshotBuffer &buffer, const Enemy &enemy);
+void read_component(SnapshotBuffer &buffer, Enemy &enemy);
+
+void write_component(SnapshotBuffer &buffer, const SpriteAnimation &animation);
+void read_component(SnapshotBuffer &buffer, SpriteAnimation &animation);
+
+void write_component(SnapshotBuffer &buffer, const BossAnimation &animation);
+void read_component(SnapshotBuffer &buffer, BossAnimation &animation);
+
+void write_component(SnapshotBuffer &buffer, const TreasureBox &treasure_box);
+void read_component(SnapshotBuffer &buffer, TreasureBox &treasure_box);
+
+void write_component(SnapshotBuffer &buffer, const BoneAnimation &animation);
+void read_component(SnapshotBuffer &buffer, BoneAnimation &animation);
+
+void write_component(SnapshotBuffer &buffer, const MeshBones &mesh_bones);
+void read_component(SnapshotBuffer &buffer, MeshBones &mesh_bones);
+
+template <>
+struct SnapshotSerializer<Enemy> : ElementwiseSnapshotSerializer<Enemy>
+{
+};
+template <>
+struct SnapshotSerializer<SpriteAnimation> : ElementwiseSnapshotSerializer<SpriteAnimation>
+{
+};
+template <>
+struct SnapshotSerializer<BossAnimation> : ElementwiseSnapshotSerializer<BossAnimation>
+{
+};
+template <>
+struct SnapshotSerializer<TreasureBox> : ElementwiseSnapshotSerializer<TreasureBox>
+{
+};
+template <>
+struct SnapshotSerializer<BoneAnimation> : ElementwiseSnapshotSerializer<BoneAnimation>
+{
+};
+template <>
+struct SnapshotSerializer<MeshBones> : ElementwiseSnapshotSerializer<MeshBones>
+{
+};
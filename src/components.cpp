@@ -19,6 +19,7 @@ void Health::take_damage(float damage)
 	{
 		health = 0;
 	}
+	registry.healths.mark_changed(*this);
 }
 
 // Very, VERY simple OBJ loader from https://github.com/opengl-tutorials/ogl tutorial 7
@@ -1,6 +1,7 @@
 #pragma once
 #include "node.hpp"
 #include "common.hpp"
+#include "level_arena.hpp"
 #include <vector>
 #include <unordered_map>
 #include "../ext/stb_image/stb_image.h"
@@ -16,7 +17,9 @@ struct Motion
 	vec2 bb_offset = {0, 0};					// offset from motion.position to center of bounding box
 	vec2 pivot_offset = {0, 0};				// before scaling
 	bool ignore_render_order = false; // if true, always rendered first (will be covered by others)
+	bool has_previous_position = false;
 	int layer = 0;										// determines render order (before y-position is considered)
+	vec2 previous_position = {0, 0}; // position before the last simulation step, for render interpolation
 };
 
 // Player component
@@ -34,7 +37,7 @@ enum class PlayerState
 struct Player
 {
 	PlayerState state = PlayerState::IDLE;
-	Entity weapon;			// current weapon
+	Entity weapon = Entity(0); // current weapon
 	vec2 weapon_offset; // weapon offset relative to player's position
 	float attack_damage = 20.0f;
 	unsigned int current_attack_id = 0;
@@ -84,9 +87,7 @@ struct DamageArea
 {
 	float time_until_active;
 	float time_until_destroyed;
-	Entity owner;
-	bool relative_position = false;
-	vec2 offset_from_owner;
+	Entity owner = Entity(0);
 	bool active = false;
 	bool single_damage = true;
 	float damage_cooldown = 0;
@@ -108,7 +109,7 @@ struct Enemy
 	float attack_damage = 10.0f;
 	unsigned int last_hit_attack_id = 0;
 	bool is_minion = false;
-	std::vector<vec2> path;
+	ArenaVector<vec2> path; // reassigned by the pathfinding every few frames
 	size_t current_path_index;
 	int pathfinding_counter;
 	vec2 last_tile_position = {0, 0};
@@ -119,10 +120,14 @@ struct SpinArea
 {
 };
 
+// Places an entity relative to its parent: the entity's Motion (its world transform) is set to the
+// parent's position plus offset (its local transform) once per physics step, after integration
 struct Attachment
 {
 	Entity parent;
-	Attachment(Entity parent_entity) : parent(parent_entity) {}
+	vec2 offset = {0.f, 0.f};
+	unsigned int depth = 0; // number of attached ancestors, parents are placed before their children
+	Attachment(Entity parent_entity, vec2 offset = {0.f, 0.f}) : parent(parent_entity), offset(offset) {}
 };
 
 enum class WeaponType
@@ -182,7 +187,6 @@ struct Dash
 
 struct PopupUI
 {
-	bool active = true;
 };
 
 struct Flow
@@ -195,7 +199,7 @@ struct Health
 {
 	float health;
 	float max_health = 100.f;
-	Entity healthbar;
+	Entity healthbar = Entity(0);
 	bool is_dead = false;
 	void take_damage(float damage);
 };
@@ -209,7 +213,7 @@ struct Energy
 {
 	float energy;
 	float max_energy = 100.f;
-	Entity energybar;
+	Entity energybar = Entity(0);
 };
 
 struct EnergyBar
@@ -229,9 +233,64 @@ enum class BodyType
 	PROJECTILE = KINEMATIC + 1,
 	NONE = PROJECTILE + 1
 };
+
+// Collision categories, one per body. Two bodies are only tested against each other if each one's
+// mask contains the other's category, pairs that fail this never reach the narrow phase.
+const uint16_t COLLISION_PLAYER = 1 << 0;
+const uint16_t COLLISION_ENEMY = 1 << 1;
+const uint16_t COLLISION_WEAPON = 1 << 2;
+const uint16_t COLLISION_PROJECTILE = 1 << 3;
+const uint16_t COLLISION_PAN = 1 << 4;
+const uint16_t COLLISION_DAMAGE_AREA = 1 << 5;
+const uint16_t COLLISION_WALL = 1 << 6; // walls and other static obstacles
+
+// The pair filter matrix: which categories a body of the given category collides with by default
+inline uint16_t default_collision_mask(uint16_t category)
+{
+	switch (category)
+	{
+	case COLLISION_PLAYER:
+		return COLLISION_PLAYER | COLLISION_ENEMY | COLLISION_PROJECTILE | COLLISION_PAN | COLLISION_DAMAGE_AREA | COLLISION_WALL;
+	case COLLISION_ENEMY:
+		return COLLISION_PLAYER | COLLISION_ENEMY | COLLISION_WEAPON | COLLISION_WALL;
+	case COLLISION_WEAPON:
+		return COLLISION_ENEMY;
+	case COLLISION_PROJECTILE:
+	case COLLISION_PAN:
+		return COLLISION_PLAYER | COLLISION_WALL;
+	case COLLISION_DAMAGE_AREA:
+		return COLLISION_PLAYER;
+	case COLLISION_WALL:
+		return COLLISION_PLAYER | COLLISION_ENEMY | COLLISION_PROJECTILE | COLLISION_PAN;
+	}
+	return 0;
+}
+
 struct PhysicsBody
 {
 	BodyType body_type = BodyType::STATIC;
+	uint16_t category = COLLISION_WALL;
+	uint16_t mask = default_collision_mask(COLLISION_WALL);
+
+	// Activity, maintained by PhysicsSystem: a body that has not moved for a few steps falls asleep and is
+	// only tested against bodies that are awake, until a contact or a velocity change wakes it up
+	bool sleeping = false;
+	unsigned int rest_steps = 0;
+	vec2 rest_position = {0, 0};
+
+	PhysicsBody(BodyType body_type = BodyType::STATIC, uint16_t category = COLLISION_WALL)
+			: body_type(body_type), category(category), mask(default_collision_mask(category)) {}
+
+	void wake()
+	{
+		sleeping = false;
+		rest_steps = 0;
+	}
+
+	bool collides_with(const PhysicsBody &other) const
+	{
+		return (mask & other.category) != 0 && (other.mask & category) != 0;
+	}
 };
 
 // Stucture to store collision information
@@ -239,7 +298,7 @@ struct Collision
 {
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
-	Collision(Entity &other) { this->other = other; };
+	Collision(Entity &other) : other(other){};
 };
 
 enum class PanState
@@ -265,6 +324,8 @@ struct Debug
 {
 	bool in_debug_mode = false;
 	bool in_freeze_mode = false;
+	bool single_threaded_systems = false; // run the system scheduler on the main thread only
+	bool show_ecs_stats = false;					// container occupancy overlay
 };
 extern Debug debugging;
 
@@ -344,12 +405,12 @@ struct BoneKeyframe
 {
 	float start_time;
 	float duration;
-	std::vector<BoneTransform> bone_transforms;
+	ArenaVector<BoneTransform> bone_transforms;
 };
 
 struct BoneAnimation
 {
-	std::vector<BoneKeyframe> keyframes;
+	ArenaVector<BoneKeyframe> keyframes;
 	int current_keyframe = 0;
 	bool loop = false;
 	float elapsed_time = 0.f;
@@ -504,6 +565,24 @@ struct BackGround
 {
 };
 
+// Values of the level_grid cells built by WorldSystem::load_level
+const int LEVEL_GRID_EMPTY = 0;
+const int LEVEL_GRID_FLOOR = 1; // the only cells the AI walks on
+const int LEVEL_GRID_WALL = 2;
+
+// The level's wall cells as one static collider, bodies are resolved against the cells they overlap
+// (see PhysicsSystem::collide_with_tilemap). Collisions with walls name the tilemap's entity as the other entity.
+struct Tilemap
+{
+	const std::vector<std::vector<int>> *cells = nullptr; // [x][y], LEVEL_GRID_WALL is solid
+	float tile_size = TILE_SCALE;
+
+	bool is_wall(int x, int y) const
+	{
+		return x >= 0 && y >= 0 && x < (int)cells->size() && y < (int)(*cells)[x].size() && (*cells)[x][y] == LEVEL_GRID_WALL;
+	}
+};
+
 struct CameraUI
 {
 	int layer = 0;
@@ -525,7 +604,7 @@ struct TreasureBox
 	WeaponType weapon_type = WeaponType::SWORD;
 	Entity item_entity = Entity(0);
 
-	std::vector<Entity> associated_minions;
+	ArenaVector<Entity> associated_minions;
 };
 
 enum class PopupType
@@ -710,7 +789,7 @@ const int geometry_count = (int)GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
 
 struct SpriteAnimation
 {
-	std::vector<TEXTURE_ASSET_ID> frames; // Texture IDs for each animation frame
+	ArenaVector<TEXTURE_ASSET_ID> frames; // Texture IDs for each animation frame
 	int current_frame = 0;								// Index of the current frame
 	float frame_duration = 0.1f;					// Duration for each frame (seconds)
 	float elapsed_time = 0.0f;						// Time since the last frame switch
@@ -719,11 +798,11 @@ struct SpriteAnimation
 
 struct BossAnimation
 {
-	std::vector<TEXTURE_ASSET_ID> attack_1; // Frames for basic attack animation
-	std::vector<TEXTURE_ASSET_ID> attack_2;
-	std::vector<TEXTURE_ASSET_ID> attack_3;
-	std::vector<TEXTURE_ASSET_ID> attack_4;
-	std::vector<TEXTURE_ASSET_ID> attack_5;
+	ArenaVector<TEXTURE_ASSET_ID> attack_1; // Frames for basic attack animation
+	ArenaVector<TEXTURE_ASSET_ID> attack_2;
+	ArenaVector<TEXTURE_ASSET_ID> attack_3;
+	ArenaVector<TEXTURE_ASSET_ID> attack_4;
+	ArenaVector<TEXTURE_ASSET_ID> attack_5;
 
 	int current_frame = 0;			 // Index of the current frame
 	float frame_duration = 0.1f; // Duration for each frame (seconds)
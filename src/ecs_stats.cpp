@@ -0,0 +1,42 @@
+// internal
+#include "ecs_stats.hpp"
+
+// stlib
+#include <fstream>
+
+#include "../ext/json.hpp"
+
+bool write_container_stats_json(const std::vector<ContainerStats> &stats, const std::string &path)
+{
+	nlohmann::json containers = nlohmann::json::array();
+	for (const ContainerStats &container : stats)
+	{
+		nlohmann::json entry;
+		entry["name"] = container.name;
+		entry["count"] = container.count;
+		entry["capacity"] = container.capacity;
+		entry["component_bytes"] = container.component_bytes;
+		entry["index_bytes"] = container.index_bytes;
+		entry["reallocations"] = container.reallocations;
+		entry["peak_count"] = container.peak_count;
+		containers.push_back(entry);
+	}
+
+	std::ofstream file(path);
+	if (!file.is_open())
+		return false;
+	file << containers.dump(4);
+	return true;
+}
+
+bool write_container_stats_csv(const std::vector<ContainerStats> &stats, const std::string &path)
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+		return false;
+	file << "name,count,capacity,component_bytes,index_bytes,reallocations,peak_count\n";
+	for (const ContainerStats &container : stats)
+		file << container.name << ',' << container.count << ',' << container.capacity << ',' << container.component_bytes << ','
+				 << container.index_bytes << ',' << container.reallocations << ',' << container.peak_count << '\n';
+	return true;
+}
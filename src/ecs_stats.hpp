@@ -0,0 +1,13 @@
+#pragma once
+
+// stlib
+#include <string>
+#include <vector>
+
+// internal
+#include "tiny_ecs.hpp"
+
+// Dumps of ECSRegistry::container_stats(), one entry / row per container
+// Both return false if the file could not be written.
+bool write_container_stats_json(const std::vector<ContainerStats> &stats, const std::string &path);
+bool write_container_stats_csv(const std::vector<ContainerStats> &stats, const std::string &path);
@@ -0,0 +1,114 @@
+// internal
+#include "job_system.hpp"
+
+// Which queue the current thread owns; threads outside the pool use queue 0
+static thread_local const JobSystem *queue_owner = nullptr;
+static thread_local unsigned int queue_index = 0;
+
+unsigned int JobSystem::default_worker_count()
+{
+	unsigned int hardware_threads = std::thread::hardware_concurrency();
+	return hardware_threads > 1 ? hardware_threads - 1 : 0;
+}
+
+JobSystem::JobSystem(unsigned int worker_count)
+{
+	for (unsigned int i = 0; i <= worker_count; i++)
+		queues.emplace_back(new Queue());
+	for (unsigned int i = 1; i <= worker_count; i++)
+		workers.emplace_back(&JobSystem::worker_loop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	wake_up.notify_all();
+	for (std::thread &worker : workers)
+		worker.join();
+}
+
+void JobSystem::run(Job job, Counter &counter)
+{
+	counter.pending++;
+	Queue &queue = *queues[current_queue()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back({std::move(job), &counter});
+	}
+	{
+		// taking the lock orders the increment before a sleeping worker re-checks its wait condition
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		queued_jobs++;
+	}
+	wake_up.notify_one();
+}
+
+void JobSystem::wait(Counter &counter)
+{
+	unsigned int own_queue = current_queue();
+	while (counter.pending > 0)
+	{
+		if (!try_run_one(own_queue))
+			std::this_thread::yield();
+	}
+}
+
+unsigned int JobSystem::current_queue() const
+{
+	return queue_owner == this ? queue_index : 0;
+}
+
+bool JobSystem::pop(unsigned int index, QueuedJob &job)
+{
+	Queue &queue = *queues[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty())
+		return false;
+	job = std::move(queue.jobs.back());
+	queue.jobs.pop_back();
+	return true;
+}
+
+bool JobSystem::steal(unsigned int thief_index, QueuedJob &job)
+{
+	for (unsigned int offset = 1; offset < queues.size(); offset++)
+	{
+		Queue &queue = *queues[(thief_index + offset) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty())
+			continue;
+		// oldest job first, the owner keeps working on the ones it queued last
+		job = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::try_run_one(unsigned int index)
+{
+	QueuedJob job;
+	if (!pop(index, job) && !steal(index, job))
+		return false;
+	queued_jobs--;
+	job.job();
+	job.counter->pending--;
+	return true;
+}
+
+void JobSystem::worker_loop(unsigned int index)
+{
+	queue_owner = this;
+	queue_index = index;
+	while (!stopping)
+	{
+		if (try_run_one(index))
+			continue;
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake_up.wait(lock, [this]()
+								 { return stopping || queued_jobs > 0; });
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// stlib
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing thread pool
+// Every thread owns a queue: it pushes and pops its own jobs at the back, and an idle worker
+// steals from the front of the other queues. The thread that created the pool owns queue 0
+// and helps running jobs while it waits for them.
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+
+	// Number of unfinished jobs of a batch, see run() and wait()
+	struct Counter
+	{
+		std::atomic<int> pending{0};
+	};
+
+	// One worker less than the hardware threads, the calling thread is the last one
+	static unsigned int default_worker_count();
+
+	explicit JobSystem(unsigned int worker_count = default_worker_count());
+	~JobSystem();
+
+	// Queues a job on the calling thread's queue, counter is decremented once it has run
+	void run(Job job, Counter &counter);
+
+	// Runs or steals queued jobs until every job of counter has finished
+	void wait(Counter &counter);
+
+	unsigned int worker_count() const { return (unsigned int)workers.size(); }
+
+private:
+	struct QueuedJob
+	{
+		Job job;
+		Counter *counter;
+	};
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<QueuedJob> jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues; // queues[0] belongs to the owning thread, queues[i] to workers[i - 1]
+	std::vector<std::thread> workers;
+
+	// Idle workers sleep here until a job is queued
+	std::mutex sleep_mutex;
+	std::condition_variable wake_up;
+	std::atomic<int> queued_jobs{0};
+	std::atomic<bool> stopping{false};
+
+	unsigned int current_queue() const;
+	bool pop(unsigned int queue_index, QueuedJob &job);
+	bool steal(unsigned int thief_index, QueuedJob &job);
+	bool try_run_one(unsigned int queue_index);
+	void worker_loop(unsigned int queue_index);
+};
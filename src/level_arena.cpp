@@ -0,0 +1,81 @@
+// internal
+#include "level_arena.hpp"
+
+// stlib
+#include <assert.h>
+#include <new>
+
+LevelArena level_arena;
+
+const size_t LevelArena::BLOCK_SIZE;
+const size_t LevelArena::MIN_CLASS_SIZE;
+const size_t LevelArena::MAX_CLASS_SIZE;
+const size_t LevelArena::CLASS_COUNT;
+
+// Index of the smallest power of two size class that fits bytes
+size_t LevelArena::size_class(size_t bytes)
+{
+	size_t index = 0;
+	for (size_t size = MIN_CLASS_SIZE; size < bytes; size *= 2)
+		index++;
+	return index;
+}
+
+void *LevelArena::allocate(size_t bytes)
+{
+	if (bytes == 0)
+		return nullptr;
+	if (bytes > MAX_CLASS_SIZE)
+		return ::operator new(bytes);
+
+	size_t index = size_class(bytes);
+	in_use += MIN_CLASS_SIZE << index;
+	if (FreeChunk *chunk = free_lists[index])
+	{
+		free_lists[index] = chunk->next;
+		return chunk;
+	}
+	return bump(MIN_CLASS_SIZE << index);
+}
+
+void LevelArena::deallocate(void *p, size_t bytes)
+{
+	if (p == nullptr)
+		return;
+	if (bytes > MAX_CLASS_SIZE)
+	{
+		::operator delete(p);
+		return;
+	}
+
+	size_t index = size_class(bytes);
+	in_use -= MIN_CLASS_SIZE << index;
+	FreeChunk *chunk = static_cast<FreeChunk *>(p);
+	chunk->next = free_lists[index];
+	free_lists[index] = chunk;
+}
+
+void *LevelArena::bump(size_t bytes)
+{
+	// chunk sizes are powers of two of at least MIN_CLASS_SIZE, so every chunk stays 16 byte aligned
+	if (blocks.empty() || block_offset + bytes > BLOCK_SIZE)
+	{
+		if (!blocks.empty())
+			current_block++;
+		if (current_block == blocks.size())
+			blocks.emplace_back(new char[BLOCK_SIZE]);
+		block_offset = 0;
+	}
+	void *p = blocks[current_block].get() + block_offset;
+	block_offset += bytes;
+	return p;
+}
+
+void LevelArena::reset()
+{
+	current_block = 0;
+	block_offset = 0;
+	for (FreeChunk *&list : free_lists)
+		list = nullptr;
+	in_use = 0;
+}
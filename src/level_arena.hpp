@@ -0,0 +1,80 @@
+#pragma once
+
+// stlib
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Memory for the dynamic data that components own (paths, animation frames, keyframes ...)
+// Allocations are carved out of large blocks and recycled through per size class free lists,
+// so the per-frame reassignments of those vectors never reach malloc. reset() drops everything
+// at once when a level is loaded; nothing allocated from the arena may be alive at that point.
+// Not thread-safe: at most one task of a scheduler wave may use it (see main.cpp).
+class LevelArena
+{
+public:
+	static const size_t BLOCK_SIZE = 64 * 1024;
+	static const size_t MIN_CLASS_SIZE = 16;
+	static const size_t MAX_CLASS_SIZE = 4096; // larger allocations go straight to operator new
+
+	LevelArena() = default;
+	LevelArena(const LevelArena &) = delete;
+	LevelArena &operator=(const LevelArena &) = delete;
+
+	void *allocate(size_t bytes);
+	void deallocate(void *p, size_t bytes);
+
+	// Forgets every allocation, keeping the blocks for the next level
+	void reset();
+
+	size_t bytes_reserved() const { return blocks.size() * BLOCK_SIZE; }
+	size_t bytes_in_use() const { return in_use; }
+
+private:
+	static const size_t CLASS_COUNT = 9; // 16, 32, ... 4096
+
+	// Unused chunk of a size class, the link is stored in the chunk itself
+	struct FreeChunk
+	{
+		FreeChunk *next;
+	};
+
+	std::vector<std::unique_ptr<char[]>> blocks;
+	size_t current_block = 0; // index into blocks that is bumped from
+	size_t block_offset = 0;	 // first unused byte of blocks[current_block]
+	FreeChunk *free_lists[CLASS_COUNT] = {};
+	size_t in_use = 0;
+
+	static size_t size_class(size_t bytes);
+	void *bump(size_t bytes);
+};
+
+extern LevelArena level_arena;
+
+// Stateless allocator over level_arena, for std containers
+template <typename T>
+struct ArenaAllocator
+{
+	typedef T value_type;
+
+	ArenaAllocator() = default;
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &) {}
+
+	T *allocate(size_t n)
+	{
+		return static_cast<T *>(level_arena.allocate(n * sizeof(T)));
+	}
+	void deallocate(T *p, size_t n)
+	{
+		level_arena.deallocate(p, n * sizeof(T));
+	}
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return true; }
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &, const ArenaAllocator<U> &) { return false; }
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -3,6 +3,7 @@
 #include <gl3w.h>
 // stlib
 #include <chrono>
+#include <cmath>
 #include <iostream>
 
 // internal
@@ -10,6 +11,7 @@
 #include "render_system.hpp"
 #include "world_system.hpp"
 #include "ai_system.hpp"
+#include "system_scheduler.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
@@ -37,8 +39,35 @@ int main()
 	world.init(&renderer);
 	ai.init(&renderer);
 
-	// variable timestep loop
+	// Frame schedule: every task names the containers it reads and writes, tasks that do not
+	// conflict run concurrently.
+	JobSystem jobs;
+	SystemScheduler scheduler(jobs);
+	const ComponentMask ALL = SystemScheduler::ALL;
+	scheduler.add("world", ALL, ALL, [&](float elapsed_ms)
+								{ world.step(elapsed_ms); });
+	scheduler.add("minion_target", registry.mask_of<Player, Motion>(), 0, [&](float)
+								{ ai.gather_minion_target(); });
+	scheduler.add("energy", 0, registry.mask_of<Energy, Player>(), [&](float elapsed_ms)
+								{ world.update_energy(elapsed_ms / 1000.f); });
+	scheduler.add("sprite_animations", registry.mask_of<Enemy>(), registry.mask_of<SpriteAnimation, RenderRequest>(), [&](float elapsed_ms)
+								{ world.update_sprite_animations(elapsed_ms); });
+	// after minion_target through Motion; the only task of its wave that uses level_arena (paths)
+	scheduler.add("minion_ai", registry.mask_of<Health, RangedMinion, SpriteAnimation>(), registry.mask_of<Enemy, Motion, RenderRequest>(), [&](float elapsed_ms)
+								{ ai.step_minions(elapsed_ms); });
+	scheduler.add("bars", registry.mask_of<Player, Energy, EnergyBar, Health, HealthBar>(), registry.mask_of<Motion>(), [&](float)
+								{ world.update_energy_bar(); world.update_health_bars(); });
+	scheduler.add("ai", ALL, ALL, [&](float elapsed_ms)
+								{ ai.step(elapsed_ms, world.levelMap); });
+	scheduler.add("physics", ALL, ALL, [&](float elapsed_ms)
+								{ physics.step(elapsed_ms); });
+	scheduler.add("collisions", ALL, ALL, [&](float)
+								{ world.handle_collisions(); });
+	scheduler.print_waves();
+
+	// fixed timestep loop, the time since the last frame is used up in steps of FIXED_STEP_MS
 	auto t = Clock::now();
+	float accumulator_ms = 0.f;
 	while (!world.is_over())
 	{
 		// Processes system messages, if this wasn't present the window would become unresponsive
@@ -49,13 +78,30 @@ int main()
 		float elapsed_ms =
 				(float)(std::chrono::duration_cast<std::chrono::microseconds>(now - t)).count() / 1000;
 		t = now;
+		world.update_fps(elapsed_ms);
 
+		// Deferred entity commands are flushed between waves, see ECSRegistry::flush_commands
 		if (!world.is_paused)
 		{
-			world.step(elapsed_ms);
-			ai.step(elapsed_ms, world.levelMap);
-			physics.step(elapsed_ms);
-			world.handle_collisions();
+			scheduler.single_threaded = debugging.single_threaded_systems;
+			accumulator_ms += elapsed_ms;
+			int steps = 0;
+			while (accumulator_ms >= FIXED_STEP_MS && steps < MAX_STEPS_PER_FRAME)
+			{
+				physics.store_previous_positions();
+				renderer.previous_camera_position = renderer.camera_position;
+				scheduler.run(FIXED_STEP_MS);
+				accumulator_ms -= FIXED_STEP_MS;
+				steps++;
+			}
+			// drop the time the cap did not allow to catch up on
+			if (accumulator_ms >= FIXED_STEP_MS)
+				accumulator_ms = std::fmod(accumulator_ms, FIXED_STEP_MS);
+			renderer.interpolation_alpha = accumulator_ms / FIXED_STEP_MS;
+		}
+		else
+		{
+			renderer.interpolation_alpha = 1.f;
 		}
 
 		renderer.draw();
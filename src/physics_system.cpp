@@ -3,6 +3,14 @@
 #include "world_init.hpp"
 
 #include <iostream>
+#include <limits>
+
+// Bodies above this width or height are kept in the AABB tree instead of the grid
+const float LARGE_BODY_SIZE = 2 * TILE_SCALE;
+// How far a swept body is placed past its time of impact, so the overlap tests see the contact
+const float CONTACT_SKIN = 0.01f;
+// Steps without movement after which a body falls asleep
+const unsigned int SLEEP_STEPS = 15;
 
 // Returns the local bounding coordinates scaled by the current size of the entity
 vec2 get_bounding_box(const Motion &motion)
@@ -15,21 +23,6 @@ vec2 xy(const vec3 &v)
 	return {v.x, v.y};
 }
 
-bool collides(const Motion &motion1, const Motion &motion2)
-{
-	// axis-aligned bounding box (AABB) collision detection
-	vec2 bb1 = get_bounding_box(motion1);
-	vec2 bb2 = get_bounding_box(motion2);
-	vec2 pos1 = motion1.position + motion1.bb_offset - bb1 / 2.f;
-	vec2 pos2 = motion2.position + motion2.bb_offset - bb2 / 2.f;
-	return pos1.x + bb1.x >= pos2.x && pos2.x + bb2.x >= pos1.x && pos1.y + bb1.y >= pos2.y && pos2.y + bb2.y >= pos1.y;
-}
-
-bool is_point_in_box(const vec2 &p, const vec2 &box_pos, const vec2 &box_bb)
-{
-	return p.x >= box_pos.x && p.x <= box_pos.x + box_bb.x && p.y >= box_pos.y && p.y <= box_pos.y + box_bb.y;
-}
-
 // computes the cross product of two vectors
 float cross(const vec2 &a, const vec2 &b)
 {
@@ -64,75 +57,345 @@ bool line_intersects(const vec2 &a1, const vec2 &a2, const vec2 &b1, const vec2
 	return t >= 0 && t <= 1 && u >= 0 && u <= 1;
 }
 
-bool mesh_collides(Entity mesh_entity, const Motion &mesh_motion, const Motion &box_motion)
+void PhysicsSystem::translate_body(const Body &body, float dx, float dy)
+{
+	body.motion->position.x += dx;
+	body.motion->position.y += dy;
+	AABBTree::Box &box = motion_boxes[body.motion_index];
+	box.min_x += dx;
+	box.max_x += dx;
+	box.min_y += dy;
+	box.max_y += dy;
+}
+
+// Depth first, so every parent is placed before its children
+static bool attachment_depth_less(Entity a, Entity b)
+{
+	return registry.attachments.get(a).depth < registry.attachments.get(b).depth;
+}
+
+void PhysicsSystem::propagate_attachments()
+{
+	auto &attachments = registry.attachments;
+	// attachments are created in depth order most of the time, so this is usually a single pass
+	attachments.sort_incremental(attachment_depth_less);
+	for (size_t i = 0; i < attachments.components.size(); i++)
+	{
+		const Attachment &attachment = attachments.components[i];
+		Motion *parent_motion = registry.motions.find(attachment.parent);
+		Motion *motion = registry.motions.find(attachments.entities[i]);
+		// a child whose parent is gone stays where it was last placed
+		if (parent_motion != nullptr && motion != nullptr)
+			motion->position = parent_motion->position + attachment.offset;
+	}
+}
+
+void PhysicsSystem::collide_with_tilemap(Entity tilemap_entity, const Tilemap &tilemap)
+{
+	const PhysicsBody &wall_body = registry.physicsBodies.get(tilemap_entity);
+	float tile = tilemap.tile_size;
+	for (const Body &body : bodies)
+	{
+		Entity entity = body.entity;
+		BodyType body_type = body.physics_body->body_type;
+		// sleeping bodies were resolved against the walls before they fell asleep
+		if (body_type == BodyType::STATIC || body.physics_body->sleeping || !body.physics_body->collides_with(wall_body))
+			continue;
+
+		// only the cells the bounding box overlaps
+		unsigned int m = body.motion_index;
+		int min_x = (int)std::floor(motion_boxes[m].min_x / tile);
+		int min_y = (int)std::floor(motion_boxes[m].min_y / tile);
+		int max_x = (int)std::floor(motion_boxes[m].max_x / tile);
+		int max_y = (int)std::floor(motion_boxes[m].max_y / tile);
+		bool hit = false;
+		bool done = false;
+		for (int y = min_y; y <= max_y && !done; y++)
+			for (int x = min_x; x <= max_x && !done; x++)
+			{
+				if (!tilemap.is_wall(x, y))
+					continue;
+				// earlier cells may have pushed the body out of this one
+				vec2 p1 = {motion_boxes[m].min_x, motion_boxes[m].min_y};
+				vec2 p2 = {x * tile, y * tile};
+				vec2 b1 = vec2(motion_boxes[m].max_x, motion_boxes[m].max_y) - p1;
+				if (p1.x + b1.x < p2.x || p2.x + tile < p1.x || p1.y + b1.y < p2.y || p2.y + tile < p1.y)
+					continue;
+
+				if (body_type == BodyType::PROJECTILE)
+				{
+					// projectiles are destroyed when they hit walls
+					registry.defer_destroy(entity);
+					done = true;
+					continue;
+				}
+
+				if (!hit)
+				{
+					// one collision event per body, as many walls as it touches
+					registry.collisions.emplace_with_duplicates(entity, tilemap_entity);
+					registry.collisions.emplace_with_duplicates(tilemap_entity, entity);
+					hit = true;
+				}
+				if (body_type == BodyType::NONE)
+				{
+					// None bodies do not need collision resolution
+					done = true;
+					continue;
+				}
+
+				// aabb collision resolution, same as against a static body
+				float overlap_x = min(p1.x + b1.x - p2.x, p2.x + tile - p1.x);
+				float overlap_y = min(p1.y + b1.y - p2.y, p2.y + tile - p1.y);
+				if (overlap_x < overlap_y)
+				{
+					translate_body(body, p1.x < p2.x ? -overlap_x : overlap_x, 0.f);
+				}
+				else
+				{
+					translate_body(body, 0.f, p1.y < p2.y ? -overlap_y : overlap_y);
+				}
+			}
+	}
+}
+
+// Time of impact in [0, 1] of the box a_min..a_max moving by d against the fixed box b_min..b_max,
+// or 1 if they do not meet. Boxes that already overlap at the start are left to the overlap tests.
+static float time_of_impact(vec2 a_min, vec2 a_max, vec2 d, vec2 b_min, vec2 b_max)
+{
+	float t_entry = -std::numeric_limits<float>::infinity();
+	float t_exit = std::numeric_limits<float>::infinity();
+	for (int axis = 0; axis < 2; axis++)
+	{
+		if (d[axis] == 0.f)
+		{
+			if (a_max[axis] < b_min[axis] || b_max[axis] < a_min[axis])
+				return 1.f;
+			continue;
+		}
+		float t1 = (b_min[axis] - a_max[axis]) / d[axis];
+		float t2 = (b_max[axis] - a_min[axis]) / d[axis];
+		t_entry = max(t_entry, min(t1, t2));
+		t_exit = min(t_exit, max(t1, t2));
+	}
+	if (t_entry > t_exit || t_entry < 0.f || t_entry > 1.f)
+		return 1.f;
+	return t_entry;
+}
+
+// Swept AABB continuous collision: the box of every fast body is swept from where it started the step
+// to where it ended up, against the wall cells and the player. A body that would have passed through
+// one is moved back to the first contact, and the overlap tests after this handle the hit as usual.
+// Other bodies are taken at their end of step positions, they move little compared to a fast body.
+void PhysicsSystem::sweep_fast_bodies(float step_seconds, Entity player)
 {
+	const Body *player_body = nullptr;
+	for (const Body &body : bodies)
+		if (body.entity == player)
+			player_body = &body;
+
+	const PhysicsBody *wall_body = nullptr;
+	const Tilemap *tilemap = nullptr;
+	if (registry.tilemaps.size() > 0)
+	{
+		wall_body = &registry.physicsBodies.get(registry.tilemaps.singleton_entity());
+		tilemap = &registry.tilemaps.singleton();
+	}
+
+	for (const Body &body : bodies)
+	{
+		// attached bodies are placed by their parent, not by their velocity
+		if (body.physics_body->body_type == BodyType::STATIC || registry.attachments.has(body.entity))
+			continue;
+		unsigned int m = body.motion_index;
+		vec2 d = body.motion->velocity * step_seconds;
+		vec2 end_min = {motion_boxes[m].min_x, motion_boxes[m].min_y};
+		vec2 end_max = {motion_boxes[m].max_x, motion_boxes[m].max_y};
+		vec2 size = end_max - end_min;
+		if (abs(d.x) <= size.x / 2 && abs(d.y) <= size.y / 2)
+			continue;
+		vec2 start_min = end_min - d;
+		vec2 start_max = end_max - d;
+
+		float t = 1.f;
+		if (wall_body != nullptr && body.physics_body->collides_with(*wall_body))
+		{
+			// the wall cells the swept box overlaps
+			float tile = tilemap->tile_size;
+			int min_x = (int)std::floor(min(start_min.x, end_min.x) / tile);
+			int min_y = (int)std::floor(min(start_min.y, end_min.y) / tile);
+			int max_x = (int)std::floor(max(start_max.x, end_max.x) / tile);
+			int max_y = (int)std::floor(max(start_max.y, end_max.y) / tile);
+			for (int y = min_y; y <= max_y; y++)
+				for (int x = min_x; x <= max_x; x++)
+				{
+					if (tilemap->is_wall(x, y))
+						t = min(t, time_of_impact(start_min, start_max, d, {x * tile, y * tile}, {(x + 1) * tile, (y + 1) * tile}));
+				}
+		}
+		if (player_body != nullptr && &body != player_body && body.physics_body->collides_with(*player_body->physics_body))
+		{
+			unsigned int p = player_body->motion_index;
+			t = min(t, time_of_impact(start_min, start_max, d, {motion_boxes[p].min_x, motion_boxes[p].min_y}, {motion_boxes[p].max_x, motion_boxes[p].max_y}));
+		}
+
+		if (t < 1.f)
+		{
+			vec2 back = -d * (1.f - t) + normalize(d) * CONTACT_SKIN;
+			translate_body(body, back.x, back.y);
+		}
+	}
+}
+
+void PhysicsSystem::update_weapon_hull(Entity weapon, const Motion &weapon_motion)
+{
+	const TexturedMesh *mesh = registry.texturedMeshPtrs.has(weapon) ? registry.texturedMeshPtrs.get(weapon) : nullptr;
+	if (weapon == hull_weapon && mesh == hull_mesh && weapon_motion.position == hull_motion.position &&
+			weapon_motion.angle == hull_motion.angle && weapon_motion.scale == hull_motion.scale &&
+			weapon_motion.pivot_offset == hull_motion.pivot_offset)
+		return;
+	hull_weapon = weapon;
+	hull_mesh = mesh;
+	hull_motion = weapon_motion;
+	weapon_triangles.clear();
+
 	// ONLY WEAPON MESH is supported
-	if (!registry.texturedMeshPtrs.has(mesh_entity))
+	if (mesh == nullptr)
 	{
-		std::cout << "mesh_collides: mesh_entity not a textured mesh" << std::endl;
-		return false;
+		std::cout << "update_weapon_hull: weapon not a textured mesh" << std::endl;
+		return;
 	}
-	TexturedMesh *mesh = registry.texturedMeshPtrs.get(mesh_entity);
-	auto &vertices = mesh->vertices;
-	auto &indices = mesh->vertex_indices;
 	// use original bounding box (without bb_scale) for actual mesh collision use
-	// vec2 mesh_bb = {abs(mesh_motion.scale.x), abs(mesh_motion.scale.y)};
-	// vec2 mesh_center = mesh_motion.position;
-	vec2 box_bb = get_bounding_box(box_motion);
-	vec2 box_pos = box_motion.position + box_motion.bb_offset - box_bb / 2.f;
-	glm::mat3 transform = get_transform(mesh_motion);
-	for (uint i = 0; i < indices.size(); i += 3)
+	glm::mat3 transform = get_transform(weapon_motion);
+	weapon_min_x = weapon_min_y = std::numeric_limits<float>::infinity();
+	weapon_max_x = weapon_max_y = -std::numeric_limits<float>::infinity();
+	for (uint i = 0; i + 2 < mesh->vertex_indices.size(); i += 3)
+	{
+		WeaponTriangle triangle;
+		for (int k = 0; k < 3; k++)
+			triangle.p[k] = xy(transform * vec3(xy(mesh->vertices[mesh->vertex_indices[i + k]].position), 1));
+		triangle.min_x = min(triangle.p[0].x, min(triangle.p[1].x, triangle.p[2].x));
+		triangle.min_y = min(triangle.p[0].y, min(triangle.p[1].y, triangle.p[2].y));
+		triangle.max_x = max(triangle.p[0].x, max(triangle.p[1].x, triangle.p[2].x));
+		triangle.max_y = max(triangle.p[0].y, max(triangle.p[1].y, triangle.p[2].y));
+		weapon_min_x = min(weapon_min_x, triangle.min_x);
+		weapon_min_y = min(weapon_min_y, triangle.min_y);
+		weapon_max_x = max(weapon_max_x, triangle.max_x);
+		weapon_max_y = max(weapon_max_y, triangle.max_y);
+		weapon_triangles.push_back(triangle);
+	}
+}
+
+bool PhysicsSystem::weapon_collides(unsigned int m) const
+{
+	vec2 box_min = {motion_boxes[m].min_x, motion_boxes[m].min_y};
+	vec2 box_max = {motion_boxes[m].max_x, motion_boxes[m].max_y};
+	if (weapon_triangles.empty() || weapon_max_x < box_min.x || box_max.x < weapon_min_x || weapon_max_y < box_min.y || box_max.y < weapon_min_y)
+		return false;
+
+	vec2 center = (box_min + box_max) * 0.5f;
+	vec2 half = (box_max - box_min) * 0.5f;
+	for (const WeaponTriangle &triangle : weapon_triangles)
 	{
-		vec2 v1 = vertices[indices[i]].position;
-		vec2 v2 = vertices[indices[i + 1]].position;
-		vec2 v3 = vertices[indices[i + 2]].position;
-		vec2 p1 = xy(transform * vec3(v1, 1));
-		vec2 p2 = xy(transform * vec3(v2, 1));
-		vec2 p3 = xy(transform * vec3(v3, 1));
-		// collides if any of the three points of the triangle is inside the box
-		if (is_point_in_box(p1, box_pos, box_bb) || is_point_in_box(p2, box_pos, box_bb) || is_point_in_box(p3, box_pos, box_bb))
+		// the box's own axes, i.e. the bounding boxes overlap
+		if (triangle.max_x < box_min.x || box_max.x < triangle.min_x || triangle.max_y < box_min.y || box_max.y < triangle.min_y)
+			continue;
+
+		// separating axis test on the normals of the three edges
+		bool separated = false;
+		for (int k = 0; k < 3 && !separated; k++)
 		{
-			// std::cout << "mesh_collides point_in_box" << std::endl;
-			return true;
+			vec2 edge = triangle.p[(k + 1) % 3] - triangle.p[k];
+			vec2 axis = {-edge.y, edge.x};
+			float box_radius = half.x * abs(axis.x) + half.y * abs(axis.y);
+			float box_center = dot(axis, center);
+			float p0 = dot(axis, triangle.p[0]);
+			float p1 = dot(axis, triangle.p[1]);
+			float p2 = dot(axis, triangle.p[2]);
+			separated = min(p0, min(p1, p2)) > box_center + box_radius || max(p0, max(p1, p2)) < box_center - box_radius;
 		}
-		// collides if any of the three edges of the triangle intersects with the box
-		if (line_intersects(p1, p2, box_pos, box_pos + vec2{box_bb.x, 0}) ||
-				line_intersects(p1, p2, box_pos, box_pos + vec2{0, box_bb.y}) ||
-				line_intersects(p1, p2, box_pos + box_bb, box_pos + box_bb - vec2{box_bb.x, 0}) ||
-				line_intersects(p1, p2, box_pos + box_bb, box_pos + box_bb - vec2{0, box_bb.y}) ||
-				line_intersects(p2, p3, box_pos, box_pos + vec2{box_bb.x, 0}) ||
-				line_intersects(p2, p3, box_pos, box_pos + vec2{0, box_bb.y}) ||
-				line_intersects(p2, p3, box_pos + box_bb, box_pos + box_bb - vec2{box_bb.x, 0}) ||
-				line_intersects(p2, p3, box_pos + box_bb, box_pos + box_bb - vec2{0, box_bb.y}) ||
-				line_intersects(p3, p1, box_pos, box_pos + vec2{box_bb.x, 0}) ||
-				line_intersects(p3, p1, box_pos, box_pos + vec2{0, box_bb.y}) ||
-				line_intersects(p3, p1, box_pos + box_bb, box_pos + box_bb - vec2{box_bb.x, 0}) ||
-				line_intersects(p3, p1, box_pos + box_bb, box_pos + box_bb - vec2{0, box_bb.y}))
-		{
-			// std::cout << "mesh_collides line_intersects" << std::endl;
+		if (!separated)
 			return true;
-		}
 	}
 	return false;
 }
 
+void PhysicsSystem::update_activity(Body &body)
+{
+	PhysicsBody &physics_body = *body.physics_body;
+	const Motion &motion = *body.motion;
+	if (physics_body.body_type == BodyType::STATIC)
+	{
+		body.resting = true;
+		return;
+	}
+
+	// sensors (damage areas, pans, the weapon) stay awake, their events do not come from moving
+	bool sensor = physics_body.body_type == BodyType::NONE && physics_body.mask != 0;
+	if (!sensor && motion.velocity == vec2(0.f, 0.f) && motion.position == physics_body.rest_position)
+	{
+		if (physics_body.rest_steps < SLEEP_STEPS)
+			physics_body.rest_steps++;
+		physics_body.sleeping = physics_body.rest_steps >= SLEEP_STEPS;
+	}
+	else
+	{
+		// moved by its velocity, a collision or directly by a system since the last step
+		physics_body.wake();
+		physics_body.rest_position = motion.position;
+	}
+	body.resting = physics_body.sleeping;
+}
+
+// Adds the pairs with a body of the tree to candidate_pairs, keeping the order of SpatialGrid::find_pairs
+void PhysicsSystem::add_large_body_pairs()
+{
+	if (large_bodies.proxy_count() == 0)
+		return;
+	for (uint i = 0; i < bodies.size(); i++)
+	{
+		const PhysicsBody &physics_body = *bodies[i].physics_body;
+		bool is_static = bodies[i].resting;
+		unsigned int m = bodies[i].motion_index;
+		large_bodies.query(motion_boxes[m],
+											 [this, i, is_static, &physics_body](unsigned int j, bool other_is_static)
+											 {
+												 if (j == i || (is_static && other_is_static) || !physics_body.collides_with(*bodies[j].physics_body))
+													 return;
+												 // moving body first, the lower index if both move
+												 if (is_static || (!other_is_static && j < i))
+													 candidate_pairs.push_back({j, i});
+												 else
+													 candidate_pairs.push_back({i, j});
+											 });
+	}
+	// two large bodies find each other twice
+	std::sort(candidate_pairs.begin(), candidate_pairs.end());
+	candidate_pairs.erase(std::unique(candidate_pairs.begin(), candidate_pairs.end()), candidate_pairs.end());
+}
+
+void PhysicsSystem::store_previous_positions()
+{
+	for (Motion &motion : registry.motions.components)
+	{
+		motion.previous_position = motion.position;
+		motion.has_previous_position = true;
+	}
+}
+
 void PhysicsSystem::step(float elapsed_ms)
 {
 	// Move all entities according to their velocity
 	auto &motion_registry = registry.motions;
-	for (uint i = 0; i < motion_registry.size(); i++)
-	{
-		Motion &motion = motion_registry.components[i];
-		// Entity entity = motion_registry.entities[i];
-		float step_seconds = elapsed_ms / 1000.f;
+	float step_seconds = elapsed_ms / 1000.f;
+	for (Motion &motion : motion_registry.components)
 		motion.position += motion.velocity * step_seconds;
-	}
 
-	// After movement, before collision checks. Do all relative position calculations here
-	Entity player = registry.players.entities[0];
-	Player &player_comp = registry.players.components[0];
+	// After movement, before collision checks. All relative positions are resolved here
+	Entity player = registry.players.singleton_entity();
+	Player &player_comp = registry.players.singleton();
 	Motion &player_motion = registry.motions.get(player);
-	// Set weapon position to correct offset from player
+	// Flip the weapon to the side the player faces, it is attached to the player at weapon_offset
 	Entity weapon = player_comp.weapon;
 	Motion &weapon_motion = registry.motions.get(weapon);
 	vec2 &weapon_offset = player_comp.weapon_offset;
@@ -146,27 +409,21 @@ void PhysicsSystem::step(float elapsed_ms)
 		weapon_offset.x = -abs(weapon_offset.x);
 		weapon_motion.angle = -weapon_motion.angle;
 	}
-	weapon_motion.position = player_motion.position + weapon_offset;
+	registry.attachments.get(weapon).offset = weapon_offset;
 
-	// Update damage area status & position
+	propagate_attachments();
+
+	// Update damage area status
 	for (int i = registry.damageAreas.components.size() - 1; i >= 0; i--)
 	{
 		DamageArea &damage_area = registry.damageAreas.components[i];
-		Entity owner_entity = damage_area.owner;
 		Entity damage_area_entity = registry.damageAreas.entities[i];
 
-		if (damage_area.relative_position && registry.motions.has(owner_entity) && registry.motions.has(damage_area_entity))
-		{
-			Motion &owner_motion = registry.motions.get(owner_entity);
-			Motion &damage_area_motion = registry.motions.get(damage_area_entity);
-
-			damage_area_motion.position = owner_motion.position + damage_area.offset_from_owner;
-		}
-
 		damage_area.time_until_destroyed -= elapsed_ms;
 		if (damage_area.time_until_destroyed <= 0.f)
 		{
-			registry.remove_all_components_of(damage_area_entity);
+			registry.defer_destroy(damage_area_entity);
+			continue;
 		}
 
 		if (!damage_area.active)
@@ -179,174 +436,176 @@ void PhysicsSystem::step(float elapsed_ms)
 		}
 	}
 
-	// Check for collisions between all moving entities
-	ComponentContainer<PhysicsBody> &physicsBody_container = registry.physicsBodies;
-	std::set<Entity> entities_to_remove;
-	for (uint i = 0; i < physicsBody_container.components.size(); i++)
+	// Sync point: expired damage areas must not take part in collision detection
+	registry.flush_commands();
+
+	// Bounding boxes of all motions after the relative position updates above
+	motion_boxes.resize(motion_registry.size());
+	for (size_t i = 0; i < motion_registry.components.size(); i++)
 	{
-		PhysicsBody &physicsBody_i = physicsBody_container.components[i];
-		if (physicsBody_i.body_type == BodyType::STATIC)
-		{
-			continue;
-		}
-		Entity entity_i = physicsBody_container.entities[i];
-		Motion &motion_i = motion_registry.get(entity_i);
+		const Motion &motion = motion_registry.components[i];
+		vec2 bb = get_bounding_box(motion);
+		AABBTree::Box &box = motion_boxes[i];
+		box.min_x = motion.position.x + motion.bb_offset.x - bb.x * 0.5f;
+		box.min_y = motion.position.y + motion.bb_offset.y - bb.y * 0.5f;
+		box.max_x = box.min_x + bb.x;
+		box.max_y = box.min_y + bb.y;
+	}
+
+	// Gather all bodies once so the pair loop below works on direct references
+	bodies.clear();
+	Motion *first_motion = motion_registry.components.data();
+	registry.view<PhysicsBody, Motion>().each([this, first_motion](Entity entity, PhysicsBody &physics_body, Motion &motion)
+																						{ bodies.push_back({entity, &physics_body, &motion, (unsigned int)(&motion - first_motion), false}); });
+
+	// Continuous collision before the broadphase, so fast bodies are bucketed where they stopped
+	sweep_fast_bodies(step_seconds, player);
 
-		for (uint j = 0; j < physicsBody_container.components.size(); j++)
+	// Broadphase: only bodies sharing a grid cell or overlapping in the tree are tested against each other,
+	// and only if their collision categories and masks accept each other
+	broadphase.begin_update();
+	large_bodies.begin_update();
+	for (uint i = 0; i < bodies.size(); i++)
+	{
+		unsigned int m = bodies[i].motion_index;
+		const PhysicsBody &physics_body = *bodies[i].physics_body;
+		update_activity(bodies[i]);
+		// sleeping bodies are bucketed like static ones, so pairs of sleeping bodies are never formed
+		bool is_static = bodies[i].resting;
+		if (motion_boxes[m].max_x - motion_boxes[m].min_x > LARGE_BODY_SIZE || motion_boxes[m].max_y - motion_boxes[m].min_y > LARGE_BODY_SIZE)
+			large_bodies.update(bodies[i].entity, i, motion_boxes[m], is_static);
+		else
+			broadphase.update(bodies[i].entity, i, motion_boxes[m].min_x, motion_boxes[m].min_y, motion_boxes[m].max_x, motion_boxes[m].max_y, is_static,
+												physics_body.category, physics_body.mask);
+	}
+	broadphase.remove_stale();
+	large_bodies.remove_stale();
+	broadphase.find_pairs(candidate_pairs);
+	add_large_body_pairs();
+
+	update_weapon_hull(weapon, registry.motions.get(weapon));
+
+	// Check for collisions between the candidate pairs, the moving body of a pair comes first
+	for (const std::pair<unsigned int, unsigned int> &pair : candidate_pairs)
+	{
+		uint i = pair.first;
+		uint j = pair.second;
+		PhysicsBody &physicsBody_i = *bodies[i].physics_body;
+		Entity entity_i = bodies[i].entity;
+		PhysicsBody &physicsBody_j = *bodies[j].physics_body;
+		Entity entity_j = bodies[j].entity;
+
+		unsigned int mi = bodies[i].motion_index;
+		unsigned int mj = bodies[j].motion_index;
+		if (motion_boxes[mi].max_x >= motion_boxes[mj].min_x && motion_boxes[mj].max_x >= motion_boxes[mi].min_x &&
+				motion_boxes[mi].max_y >= motion_boxes[mj].min_y && motion_boxes[mj].max_y >= motion_boxes[mi].min_y)
 		{
-			if (j == i)
+			vec2 p1 = {motion_boxes[mi].min_x, motion_boxes[mi].min_y};
+			vec2 p2 = {motion_boxes[mj].min_x, motion_boxes[mj].min_y};
+			vec2 b1 = vec2(motion_boxes[mi].max_x, motion_boxes[mi].max_y) - p1;
+			vec2 b2 = vec2(motion_boxes[mj].max_x, motion_boxes[mj].max_y) - p2;
+
+			if (entity_i == weapon || entity_j == weapon)
 			{
-				continue;
+				if (entity_i == weapon && !weapon_collides(mj))
+				{
+					continue;
+				}
+				if (entity_j == weapon && !weapon_collides(mi))
+				{
+					continue;
+				}
 			}
-			PhysicsBody &physicsBody_j = physicsBody_container.components[j];
-			if (j < i && physicsBody_j.body_type != BodyType::STATIC)
+
+			if (physicsBody_i.body_type == BodyType::PROJECTILE || physicsBody_j.body_type == BodyType::PROJECTILE)
 			{
-				// this pair is already processed
-				continue;
-			}
-			Entity entity_j = physicsBody_container.entities[j];
-			Motion &motion_j = motion_registry.get(entity_j);
+				bool is_i_projectile = physicsBody_i.body_type == BodyType::PROJECTILE;
+				Entity projectile_entity = is_i_projectile ? entity_i : entity_j;
+				Entity other_entity = is_i_projectile ? entity_j : entity_i;
+				PhysicsBody &other_body = is_i_projectile ? physicsBody_j : physicsBody_i;
 
-			vec2 b1 = get_bounding_box(motion_i);
-			vec2 b2 = get_bounding_box(motion_j);
-			vec2 p1 = motion_i.position + motion_i.bb_offset - b1 / 2.f;
-			vec2 p2 = motion_j.position + motion_j.bb_offset - b2 / 2.f;
+				// std::cout << "projectile_entity: " << projectile_entity << " other_entity: " << other_entity << std::endl;
+				// registry.list_all_components_of(projectile_entity);
+				// registry.list_all_components_of(other_entity);
+				// std::cout << "END" << std::endl;
 
-			if (collides(motion_i, motion_j))
-			{
-				if (entity_i == weapon || entity_j == weapon)
+				// projectiles can only damage players but not other entities
+				if (other_entity == player)
 				{
-					if (entity_i == player || entity_j == player)
-					{
-						// ignore weapon collision with player
-						continue;
-					}
-					if (entity_i == weapon && !mesh_collides(entity_i, motion_i, motion_j))
+					if (player_comp.can_take_damage())
 					{
-						continue;
+						Health &player_health = registry.healths.get(player);
+						Damage &projectile_damage = registry.damages.get(projectile_entity);
+						player_health.take_damage(projectile_damage.damage);
 					}
-					if (entity_j == weapon && !mesh_collides(entity_j, motion_j, motion_i))
-					{
-						continue;
-					}
-				}
 
-				if (physicsBody_i.body_type == BodyType::PROJECTILE && physicsBody_j.body_type == BodyType::PROJECTILE)
-				{
-					// projectiles do not collide with each other
-					continue;
+					registry.defer_destroy(projectile_entity);
 				}
-				if (physicsBody_i.body_type == BodyType::PROJECTILE || physicsBody_j.body_type == BodyType::PROJECTILE)
+				else if (other_body.body_type == BodyType::STATIC)
 				{
-					bool is_i_projectile = physicsBody_i.body_type == BodyType::PROJECTILE;
-					Entity projectile_entity = is_i_projectile ? entity_i : entity_j;
-					Entity other_entity = is_i_projectile ? entity_j : entity_i;
-					PhysicsBody &other_body = is_i_projectile ? physicsBody_j : physicsBody_i;
-
-					// std::cout << "projectile_entity: " << projectile_entity << " other_entity: " << other_entity << std::endl;
-					// registry.list_all_components_of(projectile_entity);
-					// registry.list_all_components_of(other_entity);
-					// std::cout << "END" << std::endl;
-
-					// projectiles can only damage players but not other entities
-					if (other_entity == player)
-					{
-						if (player_comp.can_take_damage())
-						{
-							Health &player_health = registry.healths.get(player);
-							Damage &projectile_damage = registry.damages.get(projectile_entity);
-							player_health.take_damage(projectile_damage.damage);
-						}
-
-						entities_to_remove.insert(projectile_entity);
-					}
-					else if (other_body.body_type == BodyType::STATIC)
-					{
-						// projectiles are destroyed when they hit walls
-						entities_to_remove.insert(projectile_entity);
-					}
-					continue;
+					// projectiles are destroyed when they hit walls
+					registry.defer_destroy(projectile_entity);
 				}
+				continue;
+			}
 
-				// std::cout << "position of i: " << p1.x << "," << p1.y << "; position of j: " << p2.x << "," << p2.y << std::endl;
-				// std::cout << "bb of i: " << b1.x << "," << b1.y << "; bb of j: " << b2.x << "," << b2.y << std::endl;
+			// std::cout << "position of i: " << p1.x << "," << p1.y << "; position of j: " << p2.x << "," << p2.y << std::endl;
+			// std::cout << "bb of i: " << b1.x << "," << b1.y << "; bb of j: " << b2.x << "," << b2.y << std::endl;
 
-				// Create a collisions event
-				// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-				registry.collisions.emplace_with_duplicates(entity_i, entity_j);
-				registry.collisions.emplace_with_duplicates(entity_j, entity_i);
+			// Create a collisions event
+			// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+			registry.collisions.emplace_with_duplicates(entity_i, entity_j);
+			registry.collisions.emplace_with_duplicates(entity_j, entity_i);
 
-				if (physicsBody_i.body_type == BodyType::NONE || physicsBody_j.body_type == BodyType::NONE)
+			// a contact with a body that moved this step wakes the other one, bodies resting against each
+			// other are left alone so they can fall asleep together
+			bool i_moved = physicsBody_i.body_type != BodyType::STATIC && physicsBody_i.rest_steps == 0;
+			bool j_moved = physicsBody_j.body_type != BodyType::STATIC && physicsBody_j.rest_steps == 0;
+			if (i_moved)
+				physicsBody_j.wake();
+			if (j_moved)
+				physicsBody_i.wake();
+
+			if (physicsBody_i.body_type == BodyType::NONE || physicsBody_j.body_type == BodyType::NONE)
+			{
+				// None bodies do not need collision resolution
+				continue;
+			}
+
+			// aabb collision resolution
+			float overlap_x = min(p1.x + b1.x - p2.x, p2.x + b2.x - p1.x);
+			float overlap_y = min(p1.y + b1.y - p2.y, p2.y + b2.y - p1.y);
+			// std::cout << "overlap: " << overlap_x << "," << overlap_y << std::endl;
+			if (physicsBody_j.body_type == BodyType::STATIC)
+			{
+				if (overlap_x < overlap_y)
 				{
-					// None bodies do not need collision resolution
-					continue;
+					translate_body(bodies[i], p1.x < p2.x ? -overlap_x : overlap_x, 0.f);
 				}
-
-				// aabb collision resolution
-				float overlap_x = min(p1.x + b1.x - p2.x, p2.x + b2.x - p1.x);
-				float overlap_y = min(p1.y + b1.y - p2.y, p2.y + b2.y - p1.y);
-				// std::cout << "overlap: " << overlap_x << "," << overlap_y << std::endl;
-				if (physicsBody_j.body_type == BodyType::STATIC)
+				else
 				{
-					if (overlap_x < overlap_y)
-					{
-						if (p1.x < p2.x)
-						{
-							motion_i.position.x -= overlap_x;
-						}
-						else
-						{
-							motion_i.position.x += overlap_x;
-						}
-					}
-					else
-					{
-						if (p1.y < p2.y)
-						{
-							motion_i.position.y -= overlap_y;
-						}
-						else
-						{
-							motion_i.position.y += overlap_y;
-						}
-					}
+					translate_body(bodies[i], 0.f, p1.y < p2.y ? -overlap_y : overlap_y);
+				}
+			}
+			else
+			{
+				if (overlap_x < overlap_y)
+				{
+					float push = p1.x < p2.x ? overlap_x / 2 : -overlap_x / 2;
+					translate_body(bodies[i], -push, 0.f);
+					translate_body(bodies[j], push, 0.f);
 				}
 				else
 				{
-					if (overlap_x < overlap_y)
-					{
-						if (p1.x < p2.x)
-						{
-							motion_i.position.x -= overlap_x / 2;
-							motion_j.position.x += overlap_x / 2;
-						}
-						else
-						{
-							motion_i.position.x += overlap_x / 2;
-							motion_j.position.x -= overlap_x / 2;
-						}
-					}
-					else
-					{
-						if (p1.y < p2.y)
-						{
-							motion_i.position.y -= overlap_y / 2;
-							motion_j.position.y += overlap_y / 2;
-						}
-						else
-						{
-							motion_i.position.y += overlap_y / 2;
-							motion_j.position.y -= overlap_y / 2;
-						}
-					}
+					float push = p1.y < p2.y ? overlap_y / 2 : -overlap_y / 2;
+					translate_body(bodies[i], 0.f, -push);
+					translate_body(bodies[j], 0.f, push);
 				}
 			}
 		}
 	}
 
-	for (Entity entity : entities_to_remove)
-	{
-		// std::cout << "removing entity " << entity << std::endl;
-		registry.remove_all_components_of(entity);
-	}
+	// Walls last, so bodies pushed around above do not end up inside them
+	if (registry.tilemaps.size() > 0)
+		collide_with_tilemap(registry.tilemaps.singleton_entity(), registry.tilemaps.singleton());
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "spatial_grid.hpp"
+#include "aabb_tree.hpp"
 
 vec2 get_bounding_box(const Motion &motion);
 vec2 xy(const vec3 &v);
@@ -14,7 +16,64 @@ class PhysicsSystem
 public:
 	void step(float elapsed_ms);
 
-	PhysicsSystem()
+	// Remembers where every motion is before the next simulation step, see RenderSystem::interpolation_alpha
+	void store_previous_positions();
+
+	PhysicsSystem() : broadphase(TILE_SCALE)
 	{
 	}
+
+private:
+	// Every entity with both a PhysicsBody and a Motion, gathered once per step
+	struct Body
+	{
+		Entity entity;
+		PhysicsBody *physics_body;
+		Motion *motion;
+		unsigned int motion_index; // into registry.motions and motion_boxes
+		bool resting;							 // static or asleep, such bodies are only paired with moving ones
+	};
+	std::vector<Body> bodies;
+	// World space bounding box of every motion, by index in registry.motions, computed once per step
+	std::vector<AABBTree::Box> motion_boxes;
+
+	// Tile sized cells, so a wall occupies a single cell
+	SpatialGrid broadphase;
+	// Bodies wider or taller than LARGE_BODY_SIZE (boss hitboxes, big damage areas) would cover many
+	// grid cells, they go into the tree instead
+	AABBTree large_bodies;
+	std::vector<std::pair<unsigned int, unsigned int>> candidate_pairs; // into bodies
+
+	// Sets the position of every attached entity from its parent's, in depth order
+	void propagate_attachments();
+
+	void add_large_body_pairs();
+
+	// Puts bodies to sleep that have been at rest for SLEEP_STEPS and wakes the ones that moved
+	void update_activity(Body &body);
+
+	// Stops bodies that move more than half their size in a step at the first wall or player contact
+	void sweep_fast_bodies(float step_seconds, Entity player);
+
+	// Resolves the moving bodies against the walls of the tilemap
+	void collide_with_tilemap(Entity tilemap_entity, const Tilemap &tilemap);
+
+	// World space triangles of the weapon mesh with their bounding boxes, rebuilt only when the weapon's
+	// transform or mesh changes, so every weapon pair of a step shares them
+	struct WeaponTriangle
+	{
+		vec2 p[3];
+		float min_x, min_y, max_x, max_y;
+	};
+	std::vector<WeaponTriangle> weapon_triangles;
+	float weapon_min_x = 0.f, weapon_min_y = 0.f, weapon_max_x = 0.f, weapon_max_y = 0.f;
+	Entity hull_weapon = Entity(0);
+	const TexturedMesh *hull_mesh = nullptr;
+	Motion hull_motion; // the transform weapon_triangles were built with
+	void update_weapon_hull(Entity weapon, const Motion &weapon_motion);
+	// Whether the weapon mesh overlaps the bounding box of the motion at index m
+	bool weapon_collides(unsigned int m) const;
+
+	// Moves a body during collision resolution, keeping its cached bounding box in sync
+	void translate_body(const Body &body, float dx, float dy);
 };
\ No newline at end of file
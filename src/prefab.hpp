@@ -0,0 +1,77 @@
+#pragma once
+
+// stlib
+#include <memory>
+#include <vector>
+
+// internal
+#include "tiny_ecs.hpp"
+
+// Component template for entities that start out identical, e.g. floor tiles, walls or projectiles
+// instantiate(count, ...) creates all entities first and then appends the template components to one
+// container after the other, reserving each container once instead of growing it per entity.
+// Per-instance values (position, velocity ...) are set on the created components afterwards.
+//
+//   Prefab wall = Prefab().with(registry.motions, wall_motion).with(registry.physicsBodies, {BodyType::STATIC, COLLISION_WALL});
+//   wall.instantiate(positions.size(), walls);
+class Prefab
+{
+	// Keeps the component type out of overload deduction, so braced initializers can be passed to with()
+	template <typename T>
+	struct Identity
+	{
+		typedef T type;
+	};
+
+public:
+	// Adds a component to the template, the prototype is copied into every instance
+	template <typename Component>
+	Prefab &with(ComponentContainer<Component> &container, const typename Identity<Component>::type &prototype)
+	{
+		parts.push_back(std::make_shared<ComponentPart<Component>>(container, prototype));
+		return *this;
+	}
+
+	// Creates count entities and appends them to created
+	void instantiate(size_t count, std::vector<Entity> &created) const
+	{
+		size_t first = created.size();
+		created.reserve(first + count);
+		for (size_t i = 0; i < count; i++)
+			created.push_back(Entity());
+		for (const std::shared_ptr<const Part> &part : parts)
+			part->insert(created.data() + first, created.data() + created.size());
+	}
+
+	Entity instantiate() const
+	{
+		Entity entity;
+		for (const std::shared_ptr<const Part> &part : parts)
+			part->insert(&entity, &entity + 1);
+		return entity;
+	}
+
+private:
+	struct Part
+	{
+		virtual ~Part() {}
+		virtual void insert(const Entity *first, const Entity *last) const = 0;
+	};
+
+	template <typename Component>
+	struct ComponentPart : Part
+	{
+		ComponentContainer<Component> &container;
+		Component prototype;
+
+		ComponentPart(ComponentContainer<Component> &container, const Component &prototype) : container(container), prototype(prototype) {}
+
+		void insert(const Entity *first, const Entity *last) const override
+		{
+			container.insert_copies(first, last, prototype);
+		}
+	};
+
+	// shared, so prefabs can be copied and extended cheaply
+	std::vector<std::shared_ptr<const Part>> parts;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+// stlib
+#include <vector>
+
+// internal
+#include "tiny_ecs.hpp"
+
+// The per-entity proxies of a broadphase (SpatialGrid, AABBTree), kept across physics steps
+// Proxies are packed the same way as in a ComponentContainer: dense arrays indexed through a SparseIndex
+// by entity. Every proxy is stamped with the step it was last updated in, so the proxies of entities that
+// went away can be dropped after the step. The owner keeps whatever else refers to proxy indices
+// (grid cells, tree leaves) up to date through the callbacks of update, remove and remove_stale.
+template <typename Proxy>
+class ProxyTable
+{
+public:
+	static const unsigned int INVALID_INDEX = SparseIndex::INVALID_INDEX;
+
+	std::vector<Proxy> proxies;
+	std::vector<Entity> entities; // owner of each proxy
+
+	// Marks the start of a physics step
+	void begin_update() { frame++; }
+
+	// Index of e's proxy, stamped with the current step, or INVALID_INDEX if e has none yet
+	// A proxy still held by a destroyed entity whose index e reuses is passed to remove_proxy(index) first.
+	template <typename RemoveProxy>
+	unsigned int update(Entity e, RemoveProxy remove_proxy)
+	{
+		unsigned int *slot = sparse.slot(e.index());
+		if (slot == nullptr || *slot == INVALID_INDEX)
+			return INVALID_INDEX;
+		if (entities[*slot] != e)
+		{
+			remove_proxy(*slot);
+			return INVALID_INDEX;
+		}
+		frames[*slot] = frame;
+		return *slot;
+	}
+
+	// Adds the proxy of e, which has none
+	unsigned int add(Entity e, const Proxy &proxy)
+	{
+		unsigned int index = (unsigned int)proxies.size();
+		sparse.slot_or_create(e.index()) = index;
+		proxies.push_back(proxy);
+		entities.push_back(e);
+		frames.push_back(frame);
+		return index;
+	}
+
+	// Removes the proxy at index by moving the last proxy into the gap
+	// move_proxy(last, index) is called before the move, while proxies[last] is still in place.
+	template <typename MoveProxy>
+	void remove(unsigned int index, MoveProxy move_proxy)
+	{
+		*sparse.slot(entities[index].index()) = INVALID_INDEX;
+		unsigned int last = (unsigned int)proxies.size() - 1;
+		if (index != last)
+		{
+			move_proxy(last, index);
+			proxies[index] = proxies[last];
+			entities[index] = entities[last];
+			frames[index] = frames[last];
+			*sparse.slot(entities[index].index()) = index;
+		}
+		proxies.pop_back();
+		entities.pop_back();
+		frames.pop_back();
+	}
+
+	// Passes every proxy that was not updated in this step to remove_proxy(index), e.g. the ones of destroyed entities
+	template <typename RemoveProxy>
+	void remove_stale(RemoveProxy remove_proxy)
+	{
+		for (unsigned int i = (unsigned int)proxies.size(); i-- > 0;)
+		{
+			if (frames[i] != frame)
+				remove_proxy(i);
+		}
+	}
+
+	size_t size() const { return proxies.size(); }
+
+private:
+	SparseIndex sparse;
+	std::vector<unsigned int> frames; // last step each proxy was updated in
+	unsigned int frame = 0;
+};
+
+template <typename Proxy>
+const unsigned int ProxyTable<Proxy>::INVALID_INDEX;
@@ -27,9 +27,15 @@ extern Popup active_popup;
 const float VIEW_CULLING_MARGIN = 200.f; // pixels in each direction to still consider in screen
 
 glm::mat3 get_transform(const Motion &motion)
+{
+	return get_transform(motion, motion.position);
+}
+
+// Transform of the motion drawn at position instead of motion.position
+glm::mat3 get_transform(const Motion &motion, vec2 position)
 {
 	Transform transform;
-	transform.translate(motion.position);
+	transform.translate(position);
 
 	transform.translate(-motion.pivot_offset * motion.scale);
 	transform.rotate(motion.angle);
@@ -49,13 +55,21 @@ BoneTransform interpolate_bone_transform(const BoneTransform &a, const BoneTrans
 	return result;
 }
 
+vec2 RenderSystem::interpolated_position(const Motion &motion) const
+{
+	// entities created during the last step have no previous position yet
+	if (!motion.has_previous_position)
+		return motion.position;
+	return motion.previous_position + (motion.position - motion.previous_position) * interpolation_alpha;
+}
+
 void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &view, const mat3 &projection)
 {
 	Motion &motion = registry.motions.get(entity);
 	// Transformation code, see Rendering and Transformation in the template
 	// specification for more info Incrementally updates transformation matrix,
 	// thus ORDER IS IMPORTANT
-	glm::mat3 transform_mat = get_transform(motion);
+	glm::mat3 transform_mat = get_transform(motion, interpolated_position(motion));
 
 	assert(registry.renderRequests.has(entity));
 	const RenderRequest &render_request = registry.renderRequests.get(entity);
@@ -129,19 +143,7 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &view, const mat3
 			gl_has_errors();
 
 			// Set bone matrices
-			std::vector<glm::mat3> bone_matrices;
-			// std::vector<MeshBone> &bones = skinned_meshes[(int)render_request.used_geometry].bones;
-			std::vector<MeshBone> &bones = registry.meshBones.get(entity).bones;
-			for (MeshBone &bone : bones)
-			{
-				glm::mat3 bone_matrix = bone.local_transform;
-				int parent_index = bone.parent_index;
-				if (parent_index != -1 && parent_index < bone_matrices.size())
-				{
-					bone_matrix = bone_matrices[parent_index] * bone_matrix;
-				}
-				bone_matrices.push_back(bone_matrix);
-			}
+			const std::vector<glm::mat3> &bone_matrices = get_bone_palette(entity);
 
 			GLuint bone_matrices_uloc = glGetUniformLocation(program, "bone_matrices");
 			glUniformMatrix3fv(bone_matrices_uloc, bone_matrices.size(), GL_FALSE, glm::value_ptr(bone_matrices[0]));
@@ -265,6 +267,30 @@ void RenderSystem::drawTexturedMesh(Entity entity, const mat3 &view, const mat3
 
 // draw the intermediate texture to the screen, with some distortion to simulate
 // water
+const std::vector<glm::mat3> &RenderSystem::get_bone_palette(Entity entity)
+{
+	auto it = bone_palettes.find(entity);
+	if (it != bone_palettes.end() && !registry.meshBones.changed_since(entity, it->second.computed_at))
+		return it->second.matrices;
+
+	BonePalette &palette = bone_palettes[entity];
+	palette.computed_at = draw_tick;
+	palette.matrices.clear();
+	// std::vector<MeshBone> &bones = skinned_meshes[(int)render_request.used_geometry].bones;
+	std::vector<MeshBone> &bones = registry.meshBones.get(entity).bones;
+	for (MeshBone &bone : bones)
+	{
+		glm::mat3 bone_matrix = bone.local_transform;
+		int parent_index = bone.parent_index;
+		if (parent_index != -1 && parent_index < palette.matrices.size())
+		{
+			bone_matrix = palette.matrices[parent_index] * bone_matrix;
+		}
+		palette.matrices.push_back(bone_matrix);
+	}
+	return palette.matrices;
+}
+
 void RenderSystem::drawToScreen()
 {
 	// Setting shaders
@@ -327,8 +353,38 @@ void RenderSystem::drawToScreen()
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
+// Draw order of render requests: world sprites by layer, then by the y position of their
+// bounding box; UI elements after all of them, by their own layer
+static bool render_order_less(Entity a, Entity b)
+{
+	CameraUI *ui_a = registry.cameraUI.find(a);
+	CameraUI *ui_b = registry.cameraUI.find(b);
+	if ((ui_a != nullptr) != (ui_b != nullptr))
+		return ui_b != nullptr;
+	if (ui_a != nullptr)
+		return ui_a->layer < ui_b->layer;
+
+	Motion *motion_a = registry.motions.find(a);
+	Motion *motion_b = registry.motions.find(b);
+	if (motion_a == nullptr || motion_b == nullptr)
+		return motion_a != nullptr && motion_b == nullptr; // never drawn, keep them at the end
+	if (motion_a->layer != motion_b->layer)
+		return motion_a->layer < motion_b->layer;
+	return motion_a->position.y + motion_a->bb_offset.y < motion_b->position.y + motion_b->bb_offset.y;
+}
+
 void RenderSystem::draw()
 {
+	// Bone palettes built in this pass are valid until their MeshBones are marked again
+	draw_tick = registry.advance_tick();
+	for (auto it = bone_palettes.begin(); it != bone_palettes.end();)
+	{
+		if (registry.meshBones.has(Entity(it->first)))
+			++it;
+		else
+			it = bone_palettes.erase(it); // boss died or level changed
+	}
+
 	// Getting size of window
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
@@ -354,33 +410,36 @@ void RenderSystem::draw()
 	mat3 camera_view = createCameraViewMatrix();
 
 	std::vector<Entity> entities_to_draw_first;
-	std::vector<std::pair<Entity, std::pair<int, float>>> entities_to_draw;
+	std::vector<Entity> entities_to_draw;
 
 	std::vector<Entity> ui_entities_to_draw_first;
-	std::vector<std::pair<Entity, int>> ui_entities_to_draw;
+	std::vector<Entity> ui_entities_to_draw;
+
+	// Keep the render requests in draw order, few of them change their place between frames
+	registry.renderRequests.sort_incremental(render_order_less);
 
 	// Draw all textured meshes that have a position and size component
 	for (Entity entity : registry.renderRequests.entities)
 	{
-		if (!registry.motions.has(entity))
+		Motion *motion_ptr = registry.motions.find(entity);
+		if (motion_ptr == nullptr)
 			continue;
+		Motion &motion = *motion_ptr;
 
-		if (registry.cameraUI.has(entity))
+		CameraUI *camera_ui = registry.cameraUI.find(entity);
+		if (camera_ui != nullptr)
 		{
-			CameraUI &camera_ui = registry.cameraUI.get(entity);
-
-			if (camera_ui.ignore_render_order)
+			if (camera_ui->ignore_render_order)
 			{
 				ui_entities_to_draw_first.push_back(entity);
 				continue;
 			}
 
-			ui_entities_to_draw.push_back(std::make_pair(entity, camera_ui.layer));
+			ui_entities_to_draw.push_back(entity);
 		}
 		else
 		{
 			// view culling
-			Motion &motion = registry.motions.get(entity);
 			vec2 half_scale = {abs(motion.scale.x) / 2.f, abs(motion.scale.y) / 2.f};
 			if ((motion.position.x + half_scale.x < camera_position.x - VIEW_CULLING_MARGIN || motion.position.x - half_scale.x > camera_position.x + window_width_px + VIEW_CULLING_MARGIN) || (motion.position.y + half_scale.y < camera_position.y - VIEW_CULLING_MARGIN || motion.position.y - half_scale.y > camera_position.y + window_height_px + VIEW_CULLING_MARGIN))
 			{
@@ -393,16 +452,10 @@ void RenderSystem::draw()
 				continue;
 			}
 
-			entities_to_draw.push_back(std::make_pair(entity, std::make_pair(motion.layer, motion.position.y + motion.bb_offset.y)));
+			entities_to_draw.push_back(entity);
 		}
 	}
 
-	// sort entities by y position
-	std::sort(entities_to_draw.begin(), entities_to_draw.end(), [](const std::pair<Entity, std::pair<int, float>> &a, const std::pair<Entity, std::pair<int, float>> &b)
-						{ return a.second.first < b.second.first || (a.second.first == b.second.first && a.second.second < b.second.second); });
-	std::sort(ui_entities_to_draw.begin(), ui_entities_to_draw.end(), [](const std::pair<Entity, int> &a, const std::pair<Entity, int> &b)
-						{ return a.second < b.second; });
-
 	// std::cout << "Entities to draw: " << entities_to_draw.size() << std::endl;
 
 	mat3 identity_view = mat3(1.0f); // Identity matrix
@@ -417,58 +470,43 @@ void RenderSystem::draw()
 		drawTexturedMesh(entity, camera_view, projection_2D);
 	}
 
-	for (auto &entry : entities_to_draw)
+	for (auto &entity : entities_to_draw)
 	{
-		drawTexturedMesh(entry.first, camera_view, projection_2D);
+		drawTexturedMesh(entity, camera_view, projection_2D);
 	}
 
-	for (auto &entry : ui_entities_to_draw)
+	for (auto &entity : ui_entities_to_draw)
 	{
-		drawTexturedMesh(entry.first, identity_view, projection_2D);
+		drawTexturedMesh(entity, identity_view, projection_2D);
 	}
 
-	for (Entity enemy : registry.enemies.entities)
+	// Turn enemies that ran out of health into corpses, once
+	for (Entity enemy : registry.live_enemies.entities())
 	{
-		auto &health = registry.healths.get(enemy);
-		auto &render_request = registry.renderRequests.get(enemy);
-		auto &motion = registry.motions.get(enemy);
+		Health &health = registry.healths.get(enemy);
+		Motion *motion = registry.motions.find(enemy);
+		RenderRequest *render_request = registry.renderRequests.find(enemy);
+		if (health.health > 0 || motion == nullptr || render_request == nullptr)
+			continue;
 
-		if (health.health <= 0)
-		{
-			if (!health.is_dead)
-			{
-				motion.scale.y *= 0.7;
-				motion.scale.x *= -1;
-				motion.scale *= 0.85;
-				health.is_dead = true;
-				PhysicsBody &enemy_physics = registry.physicsBodies.get(enemy);
-				enemy_physics.body_type = BodyType::NONE;
-			}
-			Enemy &enemy_comp = registry.enemies.get(enemy);
-			enemy_comp.state = EnemyState::DEAD;
-			if (registry.motions.has(enemy))
-			{
-				Motion &enemy_motion = registry.motions.get(enemy);
-				enemy_motion.velocity = {0.f, 0.f};
-			}
-			// Change texture to corpse
-			render_request.used_texture = TEXTURE_ASSET_ID::ENEMY_CORPSE;
-		}
-		// if in attack state and not usign attack sprite, change sprite, does not include chef
-		// auto& enemy_state = registry.enemies.get(enemy);
-		// if(enemy_state.state == EnemyState::ATTACK && !registry.chef.has(enemy) && ! (render_request.used_texture == TEXTURE_ASSET_ID::ENEMY_ATTACK)){
-		// 	render_request.used_texture = TEXTURE_ASSET_ID::ENEMY_ATTACK;
-		// 	// get motion of the enemy
-		// 	auto& enemy_motion = registry.motions.get(enemy);
-		// 	enemy_motion.scale.x *= 1.2;
-		// }
-		// if(enemy_state.state == EnemyState::COMBAT && !registry.chef.has(enemy) && ! (render_request.used_texture == TEXTURE_ASSET_ID::ENEMY)){
-		// 	render_request.used_texture = TEXTURE_ASSET_ID::ENEMY;
-		// 	auto& enemy_motion = registry.motions.get(enemy);
-		// }
+		motion->scale.y *= 0.7;
+		motion->scale.x *= -1;
+		motion->scale *= 0.85;
+		health.is_dead = true;
+		registry.healths.mark_changed(enemy);
+		registry.refresh_groups(enemy);
+		PhysicsBody &enemy_physics = registry.physicsBodies.get(enemy);
+		enemy_physics.body_type = BodyType::NONE;
+		// corpses take part in no collisions at all, not even as collision events
+		enemy_physics.mask = 0;
+
+		registry.enemies.get(enemy).state = EnemyState::DEAD;
+		motion->velocity = {0.f, 0.f};
+		// Change texture to corpse
+		render_request->used_texture = TEXTURE_ASSET_ID::ENEMY_CORPSE;
 	}
 
-	Entity spy = registry.players.entities[0];
+	Entity spy = registry.players.singleton_entity();
 	auto &health = registry.healths.get(spy);
 	auto &render_request = registry.renderRequests.get(spy);
 	auto &motion = registry.motions.get(spy);
@@ -479,6 +517,7 @@ void RenderSystem::draw()
 		{
 			motion.scale.y *= 0.65;
 			health.is_dead = true;
+			registry.healths.mark_changed(spy);
 			// implementation only consider case with 1 weapon
 			// assertion fails
 			// if(registry.playerWeapons.has(spy)){
@@ -501,6 +540,9 @@ void RenderSystem::draw()
 		}
 	}
 
+	if (debugging.show_ecs_stats)
+		drawContainerStats();
+
 	if (show_help_text)
 	{
 		// float x = 10.0f;										 // Starting x position
@@ -582,12 +624,38 @@ mat3 RenderSystem::createProjectionMatrix()
 mat3 RenderSystem::createCameraViewMatrix()
 {
 	Transform transform;
-	transform.translate(camera_position * -1.f);
+	vec2 camera = previous_camera_position + (camera_position - previous_camera_position) * interpolation_alpha;
+	transform.translate(camera * -1.f);
 	return transform.mat;
 }
 
 // boilerplate code generated with the help of gpt
 // and https://learnopengl.com/code_viewer_gh.php?code=src/7.in_practice/2.text_rendering/text_rendering.cpp
+void RenderSystem::drawContainerStats()
+{
+	const size_t MAX_LINES = 16;
+	std::vector<ContainerStats> stats = registry.container_stats();
+	std::sort(stats.begin(), stats.end(), [](const ContainerStats &a, const ContainerStats &b)
+						{ return a.component_bytes + a.index_bytes > b.component_bytes + b.index_bytes; });
+
+	float y = window_height_px - 60.f;
+	renderText("container  count / peak / capacity  KB  reallocs", 5.f, y, 0.5f, vec3(1.0, 1.0, 0.0));
+	for (size_t i = 0; i < stats.size() && i < MAX_LINES; i++)
+	{
+		const ContainerStats &container = stats[i];
+		std::stringstream line;
+		line << container.name << "  " << container.count << " / " << container.peak_count << " / " << container.capacity << "  "
+				 << (container.component_bytes + container.index_bytes) / 1024 << "  " << container.reallocations;
+		y -= 20.f;
+		renderText(line.str(), 5.f, y, 0.5f, vec3(1.0, 1.0, 0.0));
+	}
+
+	// memory the components own through level_arena, not part of the container bytes above
+	std::stringstream arena_line;
+	arena_line << "level arena  " << level_arena.bytes_in_use() / 1024 << " / " << level_arena.bytes_reserved() / 1024 << " KB";
+	renderText(arena_line.str(), 5.f, y - 20.f, 0.5f, vec3(1.0, 1.0, 0.0));
+}
+
 void RenderSystem::renderText(const std::string &text, float x, float y, float scale, vec3 color)
 {
 	// Note: (0, 0) for renderText (x, y) is the bottom-left corner of the window (instead of top-left for the rest of the game)
@@ -3,6 +3,7 @@
 #include <array>
 #include <utility>
 #include <map>
+#include <unordered_map>
 
 #include "common.hpp"
 #include "components.hpp"
@@ -21,6 +22,7 @@ struct Character
 };
 
 glm::mat3 get_transform(const Motion &motion);
+glm::mat3 get_transform(const Motion &motion, vec2 position);
 
 // System responsible for setting up OpenGL and for rendering all the
 // visual entities in the game
@@ -207,10 +209,28 @@ public:
 
 	vec2 camera_position = {0.f, 0.f};
 
+	// How far rendering is between the previous and the current simulation step, in [0, 1]
+	// Sprites are drawn at previous_position + (position - previous_position) * interpolation_alpha
+	float interpolation_alpha = 1.f;
+	vec2 previous_camera_position = {0.f, 0.f};
+
 private:
 	// Internal drawing functions for each entity type
 	void drawTexturedMesh(Entity entity, const mat3 &view, const mat3 &projection);
+	vec2 interpolated_position(const Motion &motion) const;
 	void drawToScreen();
+	// Occupancy of the largest ECS containers, toggled with L
+	void drawContainerStats();
+
+	// Bone matrices of a skinned entity, only rebuilt when its MeshBones were marked as changed
+	struct BonePalette
+	{
+		ChangeTick computed_at = 0;
+		std::vector<glm::mat3> matrices;
+	};
+	std::unordered_map<unsigned int, BonePalette> bone_palettes; // by entity id
+	ChangeTick draw_tick = 0;																		 // change tick at the start of the current draw()
+	const std::vector<glm::mat3> &get_bone_palette(Entity entity);
 
 	// Window handle
 	GLFWwindow *window;
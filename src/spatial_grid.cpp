@@ -0,0 +1,123 @@
+// internal
+#include "spatial_grid.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::CellRange SpatialGrid::cell_range(float min_x, float min_y, float max_x, float max_y) const
+{
+	return {(int)std::floor(min_x / cell_size), (int)std::floor(min_y / cell_size),
+					(int)std::floor(max_x / cell_size), (int)std::floor(max_y / cell_size)};
+}
+
+void SpatialGrid::add_to_cells(unsigned int proxy)
+{
+	const CellRange &range = table.proxies[proxy].cells;
+	for (int x = range.min_x; x <= range.max_x; x++)
+		for (int y = range.min_y; y <= range.max_y; y++)
+			cells[cell_key(x, y)].push_back(proxy);
+}
+
+void SpatialGrid::remove_from_cells(unsigned int proxy)
+{
+	replace_in_cells(proxy, SparseIndex::INVALID_INDEX);
+}
+
+// Swaps proxy for replacement in every cell it occupies, or erases it if replacement is INVALID_INDEX
+void SpatialGrid::replace_in_cells(unsigned int proxy, unsigned int replacement)
+{
+	const CellRange &range = table.proxies[proxy].cells;
+	for (int x = range.min_x; x <= range.max_x; x++)
+		for (int y = range.min_y; y <= range.max_y; y++)
+		{
+			std::vector<unsigned int> &cell = cells[cell_key(x, y)];
+			auto it = std::find(cell.begin(), cell.end(), proxy);
+			assert(it != cell.end() && "Proxy missing from its cell");
+			if (replacement != SparseIndex::INVALID_INDEX)
+			{
+				*it = replacement;
+			}
+			else
+			{
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+}
+
+void SpatialGrid::remove_proxy(unsigned int proxy)
+{
+	remove_from_cells(proxy);
+	table.remove(proxy, [this](unsigned int last, unsigned int gap)
+							 { replace_in_cells(last, gap); });
+}
+
+void SpatialGrid::update(Entity e, unsigned int body, float min_x, float min_y, float max_x, float max_y, bool is_static,
+												 uint16_t category, uint16_t mask)
+{
+	CellRange range = cell_range(min_x, min_y, max_x, max_y);
+
+	unsigned int index = table.update(e, [this](unsigned int stale)
+																		{ remove_proxy(stale); });
+	if (index == ProxyTable<Proxy>::INVALID_INDEX)
+	{
+		add_to_cells(table.add(e, {body, range, is_static, category, mask}));
+		return;
+	}
+
+	Proxy &proxy = table.proxies[index];
+	proxy.body = body;
+	proxy.is_static = is_static;
+	proxy.category = category;
+	proxy.mask = mask;
+	if (!(proxy.cells == range))
+	{
+		remove_from_cells(index);
+		proxy.cells = range;
+		add_to_cells(index);
+	}
+}
+
+void SpatialGrid::remove_stale()
+{
+	table.remove_stale([this](unsigned int proxy)
+										 { remove_proxy(proxy); });
+}
+
+void SpatialGrid::find_pairs(std::vector<std::pair<unsigned int, unsigned int>> &pairs)
+{
+	pair_keys.clear();
+	for (const Proxy &proxy : table.proxies)
+	{
+		if (proxy.is_static || proxy.mask == 0)
+			continue;
+		const CellRange &range = proxy.cells;
+		for (int x = range.min_x; x <= range.max_x; x++)
+			for (int y = range.min_y; y <= range.max_y; y++)
+			{
+				auto it = cells.find(cell_key(x, y));
+				if (it == cells.end())
+					continue;
+				for (unsigned int other_index : it->second)
+				{
+					const Proxy &other = table.proxies[other_index];
+					// a pair of moving bodies is reported from its lower body only
+					if (other.body == proxy.body || (!other.is_static && other.body < proxy.body))
+						continue;
+					if ((proxy.mask & other.category) == 0 || (other.mask & proxy.category) == 0)
+						continue;
+					pair_keys.push_back(((uint64_t)proxy.body << 32) | other.body);
+				}
+			}
+	}
+
+	// bodies sharing several cells show up once per shared cell
+	std::sort(pair_keys.begin(), pair_keys.end());
+	pair_keys.erase(std::unique(pair_keys.begin(), pair_keys.end()), pair_keys.end());
+
+	pairs.clear();
+	pairs.reserve(pair_keys.size());
+	for (uint64_t key : pair_keys)
+		pairs.push_back({(unsigned int)(key >> 32), (unsigned int)key});
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// stlib
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// internal
+#include "proxy_table.hpp"
+
+// Uniform grid broadphase
+// Every body has a proxy that remembers the range of cells its bounding box covers. Proxies are kept
+// across frames and only re-bucketed when that range changes, so static walls are inserted once per
+// level and moving bodies touch the grid only when they cross a cell border.
+class SpatialGrid
+{
+public:
+	explicit SpatialGrid(float cell_size) : cell_size(cell_size) {}
+
+	// Marks the start of a physics step, proxies that are not updated before remove_stale() are dropped
+	void begin_update() { table.begin_update(); }
+
+	// Inserts or moves the proxy of e; body is the caller's index for e in this step
+	// category and mask are the body's collision bits, see PhysicsBody::collides_with
+	void update(Entity e, unsigned int body, float min_x, float min_y, float max_x, float max_y, bool is_static,
+							uint16_t category, uint16_t mask);
+
+	// Drops the proxies of entities that were not updated in this step, e.g. destroyed ones
+	void remove_stale();
+
+	// Replaces pairs by every pair of bodies sharing a cell where at least one of them is not static and
+	// whose collision masks accept each other
+	// Each pair is reported once as (first, second): the non-static body first, or the lower body index
+	// if both move. Pairs are sorted, so they come in the order a nested loop over the bodies would see them.
+	void find_pairs(std::vector<std::pair<unsigned int, unsigned int>> &pairs);
+
+	size_t proxy_count() const { return table.size(); }
+
+private:
+	struct CellRange
+	{
+		int min_x, min_y, max_x, max_y;
+		bool operator==(const CellRange &other) const
+		{
+			return min_x == other.min_x && min_y == other.min_y && max_x == other.max_x && max_y == other.max_y;
+		}
+	};
+
+	struct Proxy
+	{
+		unsigned int body;
+		CellRange cells;
+		bool is_static;
+		uint16_t category, mask;
+	};
+
+	float cell_size;
+	ProxyTable<Proxy> table;
+
+	// Proxy indices per occupied cell; emptied cells keep their vectors for reuse
+	std::unordered_map<uint64_t, std::vector<unsigned int>> cells;
+	std::vector<uint64_t> pair_keys; // scratch of find_pairs
+
+	static uint64_t cell_key(int x, int y)
+	{
+		return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+	}
+	CellRange cell_range(float min_x, float min_y, float max_x, float max_y) const;
+
+	void add_to_cells(unsigned int proxy);
+	void remove_from_cells(unsigned int proxy);
+	void remove_proxy(unsigned int proxy);
+	void replace_in_cells(unsigned int proxy, unsigned int replacement);
+};
@@ -0,0 +1,78 @@
+// internal
+#include "system_scheduler.hpp"
+#include "tiny_ecs_registry.hpp"
+
+// stlib
+#include <cstdio>
+
+const ComponentMask SystemScheduler::ALL;
+
+bool SystemScheduler::conflicts(const Task &a, const Task &b)
+{
+	return (a.writes & (b.reads | b.writes)) != 0 || (b.writes & a.reads) != 0;
+}
+
+void SystemScheduler::add(const std::string &name, ComponentMask reads, ComponentMask writes, std::function<void(float)> task)
+{
+	tasks.push_back({name, reads, writes, std::move(task)});
+	unsigned int index = (unsigned int)tasks.size() - 1;
+
+	// earliest wave after every earlier task this one conflicts with
+	size_t wave = 0;
+	for (size_t w = 0; w < waves.size(); w++)
+		for (unsigned int other : waves[w])
+			if (conflicts(tasks[other], tasks[index]))
+				wave = w + 1;
+
+	if (wave == waves.size())
+		waves.emplace_back();
+	waves[wave].push_back(index);
+}
+
+void SystemScheduler::run(float elapsed_ms)
+{
+	if (single_threaded)
+	{
+		for (Task &task : tasks)
+		{
+			task.run(elapsed_ms);
+			registry.flush_commands();
+		}
+		return;
+	}
+
+	for (const std::vector<unsigned int> &wave : waves)
+	{
+		if (wave.size() == 1)
+		{
+			// alone in its wave, e.g. whole systems that talk to GLFW and SDL and must stay on the main thread
+			tasks[wave[0]].run(elapsed_ms);
+		}
+		else
+		{
+			JobSystem::Counter counter;
+			for (unsigned int index : wave)
+			{
+				Task *task = &tasks[index];
+				jobs.run([task, elapsed_ms]()
+								 { task->run(elapsed_ms); },
+								 counter);
+			}
+			jobs.wait(counter);
+		}
+		// sync point
+		registry.flush_commands();
+	}
+}
+
+void SystemScheduler::print_waves() const
+{
+	printf("System schedule on %u worker threads:\n", jobs.worker_count());
+	for (size_t w = 0; w < waves.size(); w++)
+	{
+		printf("  wave %d:", (int)w);
+		for (unsigned int index : waves[w])
+			printf(" %s", tasks[index].name.c_str());
+		printf("\n");
+	}
+}
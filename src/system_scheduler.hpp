@@ -0,0 +1,54 @@
+#pragma once
+
+// stlib
+#include <functional>
+#include <string>
+#include <vector>
+
+// internal
+#include "tiny_ecs.hpp"
+#include "job_system.hpp"
+
+// Runs the per-frame systems of the game
+// Every task declares the component containers it reads and writes (as ECSRegistry::mask_of bits).
+// A task never runs before an earlier task it conflicts with, so tasks are grouped into waves of
+// non-conflicting tasks that run concurrently on the job system. Deferred entity commands are
+// flushed between waves.
+//
+// Tasks running concurrently must stay inside their declared containers and must not create or
+// destroy entities or record deferred commands; whole systems (world, ai, physics) are declared
+// with ALL and always run alone on the calling thread.
+class SystemScheduler
+{
+public:
+	static const ComponentMask ALL = ~ComponentMask(0);
+
+	explicit SystemScheduler(JobSystem &jobs) : jobs(jobs) {}
+
+	void add(const std::string &name, ComponentMask reads, ComponentMask writes, std::function<void(float)> task);
+
+	// One frame of all tasks
+	void run(float elapsed_ms);
+
+	// Prints which tasks share a wave
+	void print_waves() const;
+
+	// Runs every task on the calling thread in the order they were added, with a sync point after
+	// each one, for reproducible debugging sessions
+	bool single_threaded = false;
+
+private:
+	struct Task
+	{
+		std::string name;
+		ComponentMask reads;
+		ComponentMask writes;
+		std::function<void(float)> run;
+	};
+
+	JobSystem &jobs;
+	std::vector<Task> tasks;
+	std::vector<std::vector<unsigned int>> waves; // indices into tasks, in the order they were added
+
+	static bool conflicts(const Task &a, const Task &b);
+};
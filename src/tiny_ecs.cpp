@@ -1,5 +1,46 @@
 // internal
 #include "tiny_ecs.hpp"
 
+// stlib
+#include <cstdlib>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
 // All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+unsigned int Entity::id_count = 1;
+std::vector<unsigned int> Entity::free_indices;
+std::vector<unsigned int> Entity::versions;
+
+const unsigned int Entity::INDEX_BITS;
+const unsigned int Entity::INDEX_MASK;
+const unsigned int Entity::VERSION_MASK;
+
+const unsigned int SparseIndex::PAGE_SIZE;
+const unsigned int SparseIndex::INVALID_INDEX;
+
+// Starts at 1 so that components added before the first advance_tick() count as changed since tick 0
+std::atomic<ChangeTick> ContainerInterface::change_tick(1);
+
+unsigned int next_container_type_id()
+{
+	static std::atomic<unsigned int> next_id(0);
+	return next_id.fetch_add(1);
+}
+
+std::string readable_type_name(const std::type_info &type)
+{
+	std::string name = type.name();
+#if defined(__GNUG__)
+	int status = 0;
+	char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+	if (status == 0 && demangled != nullptr)
+		name = demangled;
+	std::free(demangled);
+#endif
+	// keep only the template argument of the container
+	size_t open = name.find('<');
+	if (open != std::string::npos && name.back() == '>')
+		name = name.substr(open + 1, name.size() - open - 2);
+	return name;
+}
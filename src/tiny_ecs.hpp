@@ -3,47 +3,535 @@
 #include <algorithm>
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <type_traits>
+#include <tuple>
+#include <utility>
 #include <set>
 #include <functional>
 #include <typeindex>
+#include <cstdint>
+#include <atomic>
+#include <cstring>
+#include <string>
 #include <assert.h>
 
+// Growable byte buffer that registry snapshots are written to and restored from
+// It only lives in memory, so pointer members (e.g. Mesh *) stay meaningful.
+class SnapshotBuffer
+{
+	std::vector<char> bytes;
+	size_t read_position = 0;
+
+public:
+	void clear()
+	{
+		bytes.clear();
+		read_position = 0;
+	}
+	void rewind() { read_position = 0; }
+	bool empty() const { return bytes.empty(); }
+	size_t size() const { return bytes.size(); }
+
+	void write(const void *data, size_t size)
+	{
+		const char *begin = static_cast<const char *>(data);
+		bytes.insert(bytes.end(), begin, begin + size);
+	}
+	void read(void *data, size_t size)
+	{
+		assert(read_position + size <= bytes.size() && "Reading past the end of a snapshot");
+		if (size > 0)
+			memcpy(data, bytes.data() + read_position, size);
+		read_position += size;
+	}
+
+	template <typename T>
+	void write_value(const T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written directly");
+		write(&value, sizeof(T));
+	}
+	template <typename T>
+	void read_value(T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be read directly");
+		read(&value, sizeof(T));
+	}
+
+	// Element count followed by the raw elements
+	template <typename T, typename Allocator>
+	void write_vector(const std::vector<T, Allocator> &values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only vectors of trivially copyable values can be written directly");
+		write_value((uint64_t)values.size());
+		write(values.data(), values.size() * sizeof(T));
+	}
+	template <typename T, typename Allocator>
+	void read_vector(std::vector<T, Allocator> &values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only vectors of trivially copyable values can be read directly");
+		uint64_t count;
+		read_value(count);
+		read_elements(values, (size_t)count, std::is_default_constructible<T>());
+	}
+
+private:
+	template <typename T, typename Allocator>
+	void read_elements(std::vector<T, Allocator> &values, size_t count, std::true_type)
+	{
+		values.resize(count);
+		read(values.data(), count * sizeof(T));
+	}
+	// Components such as Collision have no default constructor, so copy them in one at a time
+	template <typename T, typename Allocator>
+	void read_elements(std::vector<T, Allocator> &values, size_t count, std::false_type)
+	{
+		values.clear();
+		values.reserve(count);
+		typename std::aligned_storage<sizeof(T), alignof(T)>::type element;
+		for (size_t i = 0; i < count; i++)
+		{
+			read(&element, sizeof(T));
+			values.push_back(*reinterpret_cast<T *>(&element));
+		}
+	}
+};
+
 // Unique identifyer for all entities
+// The id packs a slot index (low bits) and a version (high bits). Destroying an entity bumps the
+// version of its slot and puts the index on a free list, so indices stay dense across restarts
+// and handles to destroyed entities can be detected with is_valid().
 class Entity
 {
 	unsigned int id;
-	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
+	static unsigned int id_count;										 // next never used index, starts from 1, entity 0 is the default initialization
+	static std::vector<unsigned int> free_indices; // destroyed indices waiting for re-use
+	static std::vector<unsigned int> versions;		 // current version of every index handed out so far
+
 public:
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int VERSION_MASK = ~0u >> INDEX_BITS;
+
 	Entity()
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		unsigned int index;
+		if (!free_indices.empty())
+		{
+			index = free_indices.back();
+			free_indices.pop_back();
+		}
+		else
+		{
+			index = id_count++;
+			assert(index <= INDEX_MASK && "Ran out of entity indices");
+			versions.resize(index + 1, 0);
+		}
+		id = index | (versions[index] << INDEX_BITS);
 	}
 	Entity(unsigned int id) : id(id) {}
-	operator unsigned int() { return id; } // this enables automatic casting to int
+	operator unsigned int() const { return id; } // this enables automatic casting to int
 	bool operator<(const Entity &other) const
 	{
 		return id < other.id;
 	}
+
+	unsigned int index() const { return id & INDEX_MASK; }
+	unsigned int version() const { return id >> INDEX_BITS; }
+
+	// False for Entity(0) and for handles whose entity has been destroyed since
+	bool is_valid() const
+	{
+		return index() != 0 && index() < versions.size() && versions[index()] == version();
+	}
+
+	// Invalidate all handles to e and recycle its index, destroying an invalid handle does nothing
+	static void destroy(Entity e)
+	{
+		if (!e.is_valid())
+			return;
+		versions[e.index()] = (versions[e.index()] + 1) & VERSION_MASK;
+		free_indices.push_back(e.index());
+	}
+
+	// Number of indices currently handed out, including destroyed ones waiting for re-use
+	static unsigned int index_count() { return id_count; }
+
+	// The allocator state is part of registry snapshots so that restored handles stay valid
+	static void save_allocator(SnapshotBuffer &buffer)
+	{
+		buffer.write_value(id_count);
+		buffer.write_vector(free_indices);
+		buffer.write_vector(versions);
+	}
+	static void restore_allocator(SnapshotBuffer &buffer)
+	{
+		buffer.read_value(id_count);
+		buffer.read_vector(free_indices);
+		buffer.read_vector(versions);
+	}
+};
+
+// How the dense component array of a container is written into a snapshot
+// Trivially copyable components are copied as one block. Components that own heap data
+// (vectors) specialize this with ElementwiseSnapshotSerializer, see component_snapshot.hpp.
+template <typename Component>
+struct SnapshotSerializer
+{
+	static_assert(std::is_trivially_copyable<Component>::value, "Components owning heap data need a SnapshotSerializer specialization");
+	static void write(SnapshotBuffer &buffer, const std::vector<Component> &components)
+	{
+		buffer.write_vector(components);
+	}
+	static void read(SnapshotBuffer &buffer, std::vector<Component> &components)
+	{
+		buffer.read_vector(components);
+	}
+};
+
+// Writes components one by one through write_component(buffer, c) / read_component(buffer, c) overloads
+template <typename Component>
+struct ElementwiseSnapshotSerializer
+{
+	static void write(SnapshotBuffer &buffer, const std::vector<Component> &components)
+	{
+		buffer.write_value((uint64_t)components.size());
+		for (const Component &component : components)
+			write_component(buffer, component);
+	}
+	static void read(SnapshotBuffer &buffer, std::vector<Component> &components)
+	{
+		uint64_t count;
+		buffer.read_value(count);
+		components.resize((size_t)count);
+		for (Component &component : components)
+			read_component(buffer, component);
+	}
+};
+
+// One bit per registered container, set while the entity owns a component of that type
+typedef uint64_t ComponentMask;
+const unsigned int MAX_COMPONENT_TYPES = 64;
+
+// Index of the lowest set bit of a non-zero mask
+inline unsigned int lowest_component_bit(ComponentMask mask)
+{
+	assert(mask != 0);
+#if defined(_MSC_VER)
+	unsigned long bit;
+	_BitScanForward64(&bit, mask);
+	return (unsigned int)bit;
+#else
+	return (unsigned int)__builtin_ctzll(mask);
+#endif
+}
+
+// The component masks of all entities, indexed by entity index
+class EntityGroup;
+
+class ComponentSignatures
+{
+	std::vector<ComponentMask> masks;
+	// Groups to tell about changed signatures, see EntityGroup
+	std::vector<EntityGroup *> groups;
+
+	inline void notify_groups(Entity e, ComponentMask bit);
+
+public:
+	ComponentMask get(Entity e) const
+	{
+		return e.index() < masks.size() ? masks[e.index()] : 0;
+	}
+	void set_bit(Entity e, unsigned int component_id)
+	{
+		if (e.index() >= masks.size())
+			masks.resize(e.index() + 1, 0);
+		masks[e.index()] |= ComponentMask(1) << component_id;
+		notify_groups(e, ComponentMask(1) << component_id);
+	}
+	void clear_bit(Entity e, unsigned int component_id)
+	{
+		if (e.index() < masks.size())
+			masks[e.index()] &= ~(ComponentMask(1) << component_id);
+		notify_groups(e, ComponentMask(1) << component_id);
+	}
+	void add_group(EntityGroup *group)
+	{
+		groups.push_back(group);
+	}
+	// Re-check e in every group, after changing a field that group filters look at
+	inline void refresh_groups(Entity e);
+	inline void update_groups();
 };
 
+// Epoch in which a component was last added or marked as changed, see ComponentContainer::changed_since
+typedef uint32_t ChangeTick;
+
+// Demangled name of a type, for containers the component type, e.g. "Motion" for ComponentContainer<Motion>
+std::string readable_type_name(const std::type_info &type);
+
+// Memory and occupancy of one container, see ECSRegistry::container_stats
+// Byte counts are the reserved sizes of the container's own arrays; memory that components own
+// themselves (e.g. ArenaVector members) is not included.
+struct ContainerStats
+{
+	std::string name;
+	size_t count = 0;
+	size_t capacity = 0;
+	size_t component_bytes = 0; // the dense component array
+	size_t index_bytes = 0;			// entities, change ticks and the sparse index pages
+	size_t reallocations = 0;		// growths of the component array since the program started
+	size_t peak_count = 0;			// since the last reset_peak(), i.e. since the level was loaded
+};
+
+// Dense id of a container type, handed out on first use; ECSRegistry indexes its containers by it
+unsigned int next_container_type_id();
+template <typename Container>
+unsigned int container_type_id()
+{
+	// function-local statics are initialized thread safely, so workers may ask for new types too
+	static const unsigned int id = next_container_type_id();
+	return id;
+}
+
 // Common interface to refer to all containers in the ECS registry
 struct ContainerInterface
 {
+	// The epoch stamped on components right now, advanced by ECSRegistry::advance_tick()
+	static std::atomic<ChangeTick> change_tick;
+
 	virtual void clear() = 0;
 	virtual size_t size() = 0;
 	virtual void remove(Entity e) = 0;
 	virtual bool has(Entity entity) = 0;
+	// Append the container's contents to a snapshot / replace them by the next container in a snapshot
+	virtual void save(SnapshotBuffer &buffer) = 0;
+	virtual void load(SnapshotBuffer &buffer) = 0;
+	// Fills everything but the name
+	virtual ContainerStats stats() = 0;
+	// container_type_id of the concrete container class
+	virtual unsigned int type_id() const = 0;
+
+	// Telemetry, kept up to date by the inserting functions
+	size_t reallocations = 0;
+	size_t peak_count = 0;
+	void reset_peak()
+	{
+		peak_count = size();
+	}
+
+	// Set by the registry, containers that are not registered keep no signatures
+	ComponentSignatures *signatures = nullptr;
+	unsigned int component_id = 0;
+	void register_signature(ComponentSignatures *signature_store, unsigned int id)
+	{
+		assert(id < MAX_COMPONENT_TYPES && "Too many component types for ComponentMask");
+		signatures = signature_store;
+		component_id = id;
+	}
+};
+
+// Paged sparse array from entity index -> dense array index, shared by the container types below
+// Pages are allocated lazily so that large entity indices stay cheap.
+class SparseIndex
+{
+	static const unsigned int PAGE_SIZE = 1024;
+	std::vector<std::unique_ptr<unsigned int[]>> pages;
+
+public:
+	static const unsigned int INVALID_INDEX = ~0u;
+
+	// Returns the slot holding the dense index of an entity index, or nullptr if its page was never allocated
+	inline unsigned int *slot(unsigned int index)
+	{
+		unsigned int page = index / PAGE_SIZE;
+		if (page >= pages.size() || !pages[page])
+			return nullptr;
+		return &pages[page][index % PAGE_SIZE];
+	}
+
+	// Returns the slot of an entity index, allocating its page on first use
+	unsigned int &slot_or_create(unsigned int index)
+	{
+		unsigned int page = index / PAGE_SIZE;
+		if (page >= pages.size())
+			pages.resize(page + 1);
+		if (!pages[page])
+		{
+			pages[page].reset(new unsigned int[PAGE_SIZE]);
+			std::fill(pages[page].get(), pages[page].get() + PAGE_SIZE, (unsigned int)INVALID_INDEX);
+		}
+		return pages[page][index % PAGE_SIZE];
+	}
+
+	// Memory held by the page table and the allocated pages
+	size_t bytes() const
+	{
+		size_t bytes = pages.capacity() * sizeof(pages[0]);
+		for (const std::unique_ptr<unsigned int[]> &page : pages)
+			if (page)
+				bytes += PAGE_SIZE * sizeof(unsigned int);
+		return bytes;
+	}
+
+	// Dense index of e if the entry at its index belongs to exactly this handle
+	unsigned int find(Entity e, const std::vector<Entity> &entities)
+	{
+		unsigned int *s = slot(e.index());
+		if (s == nullptr || *s == INVALID_INDEX || entities[*s] != e)
+			return INVALID_INDEX;
+		return *s;
+	}
+};
+
+// An incrementally maintained set of entities, e.g. "all enemies that are still alive"
+// Members have every component of all_of, at least one of any_of (unless it is 0), none of none_of,
+// and pass the optional filter on their field values. Signature changes reach the group on their
+// own; after changing a field the filter looks at (e.g. Health::is_dead), call refresh(e).
+// Changes are applied when the members are next accessed or at the next sync point, so a loop over
+// entities() may add and remove components freely as long as it does not query the same group inside.
+class EntityGroup
+{
+	ComponentSignatures *signatures = nullptr;
+	ComponentMask all_of = 0;
+	ComponentMask any_of = 0;
+	ComponentMask none_of = 0;
+	std::function<bool(Entity)> filter;
+
+	SparseIndex sparse;
+	std::vector<Entity> members;
+	std::vector<Entity> pending; // entities to re-evaluate, may contain duplicates and destroyed handles
+
+	bool matches(Entity e) const
+	{
+		if (!e.is_valid())
+			return false;
+		ComponentMask signature = signatures->get(e);
+		if ((signature & all_of) != all_of || (signature & none_of) != 0)
+			return false;
+		if (any_of != 0 && (signature & any_of) == 0)
+			return false;
+		return !filter || filter(e);
+	}
+
+	void remove_at(unsigned int position)
+	{
+		*sparse.slot(members[position].index()) = SparseIndex::INVALID_INDEX;
+		if (position + 1 != members.size())
+		{
+			members[position] = members.back();
+			*sparse.slot(members[position].index()) = position;
+		}
+		members.pop_back();
+	}
+
+	void evaluate(Entity e)
+	{
+		unsigned int position = SparseIndex::INVALID_INDEX;
+		if (unsigned int *s = sparse.slot(e.index()))
+			position = *s;
+		// a destroyed handle whose index has been handed out again
+		if (position != SparseIndex::INVALID_INDEX && members[position] != e)
+		{
+			remove_at(position);
+			position = SparseIndex::INVALID_INDEX;
+		}
+
+		bool member = position != SparseIndex::INVALID_INDEX;
+		if (matches(e) == member)
+			return;
+		if (member)
+			remove_at(position);
+		else
+		{
+			sparse.slot_or_create(e.index()) = (unsigned int)members.size();
+			members.push_back(e);
+		}
+	}
+
+public:
+	// Apply the pending changes now, also done by the registry at every sync point
+	void update()
+	{
+		for (size_t i = 0; i < pending.size(); i++)
+			evaluate(pending[i]);
+		pending.clear();
+	}
+
+	// Called once by the registry, signatures is where the members' component bits are kept
+	void define(ComponentSignatures *signature_store, ComponentMask all_of_mask, ComponentMask any_of_mask, ComponentMask none_of_mask, std::function<bool(Entity)> filter_function = nullptr)
+	{
+		signatures = signature_store;
+		all_of = all_of_mask;
+		any_of = any_of_mask;
+		none_of = none_of_mask;
+		filter = filter_function;
+		signatures->add_group(this);
+	}
+
+	bool watches(ComponentMask bit) const
+	{
+		return ((all_of | any_of | none_of) & bit) != 0;
+	}
+
+	// Re-check e on the next access
+	void refresh(Entity e)
+	{
+		pending.push_back(e);
+	}
+
+	// The current members, in no particular order
+	const std::vector<Entity> &entities()
+	{
+		update();
+		return members;
+	}
+
+	bool has(Entity e)
+	{
+		update();
+		return sparse.find(e, members) != SparseIndex::INVALID_INDEX;
+	}
+
+	size_t size()
+	{
+		update();
+		return members.size();
+	}
 };
 
+void ComponentSignatures::notify_groups(Entity e, ComponentMask bit)
+{
+	for (EntityGroup *group : groups)
+		if (group->watches(bit))
+			group->refresh(e);
+}
+
+void ComponentSignatures::refresh_groups(Entity e)
+{
+	for (EntityGroup *group : groups)
+		group->refresh(e);
+}
+
+void ComponentSignatures::update_groups()
+{
+	for (EntityGroup *group : groups)
+		group->update();
+}
+
 // A container that stores components of type 'Component' and associated entities
+// Lookups go through a sparse set: a paged array indexed by entity id holds the
+// position of the entity's component in the dense 'components'/'entities' arrays.
 template <typename Component> // A component can be any class
 class ComponentContainer : public ContainerInterface
 {
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
+	static const unsigned int INVALID_INDEX = SparseIndex::INVALID_INDEX;
+	SparseIndex sparse;
 	bool registered = false;
+	// Scratch permutation of sort(), kept to avoid allocating on every call
+	std::vector<unsigned int> sort_order;
 
 public:
 	// Container of all components of type 'Component'
@@ -52,6 +540,9 @@ public:
 	// The corresponding entities
 	std::vector<Entity> entities;
 
+	// Change epoch of every component, parallel to components
+	std::vector<ChangeTick> change_ticks;
+
 	// Constructor that registers the type
 	ComponentContainer()
 	{
@@ -63,12 +554,54 @@ public:
 		// Usually, every entity should only have one instance of each component type
 		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		unsigned int &slot = sparse.slot_or_create(e.index());
+		assert((slot == INVALID_INDEX || entities[slot] == e) && "Index still used by a destroyed entity");
+		slot = (unsigned int)components.size();
+		size_t capacity = components.capacity();
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
+		change_ticks.push_back(change_tick.load(std::memory_order_relaxed));
+		if (components.capacity() != capacity)
+			reallocations++;
+		peak_count = std::max(peak_count, components.size());
+		if (signatures)
+			signatures->set_bit(e, component_id);
 		return components.back();
 	};
 
+	// Makes room for n more components at once, keeping the geometric growth of push_back
+	void reserve_additional(size_t n)
+	{
+		size_t needed = components.size() + n;
+		if (needed <= components.capacity())
+			return;
+		size_t capacity = std::max(needed, components.capacity() * 2);
+		components.reserve(capacity);
+		entities.reserve(capacity);
+		change_ticks.reserve(capacity);
+		reallocations++;
+	}
+
+	// Inserts a copy of prototype for every entity in [first, last) with a single reservation, see Prefab
+	void insert_copies(const Entity *first, const Entity *last, const Component &prototype)
+	{
+		reserve_additional(last - first);
+		ChangeTick tick = change_tick.load(std::memory_order_relaxed);
+		for (const Entity *e = first; e != last; e++)
+		{
+			assert(!has(*e) && "Entity already contained in ECS registry");
+			unsigned int &slot = sparse.slot_or_create(e->index());
+			assert((slot == INVALID_INDEX || entities[slot] == *e) && "Index still used by a destroyed entity");
+			slot = (unsigned int)components.size();
+			components.push_back(prototype);
+			entities.push_back(*e);
+			change_ticks.push_back(tick);
+			if (signatures)
+				signatures->set_bit(*e, component_id);
+		}
+		peak_count = std::max(peak_count, components.size());
+	}
+
 	// The emplace function takes the the provided arguments Args, creates a new object of type Component, and inserts it into the ECS system
 	template <typename... Args>
 	Component &emplace(Entity e, Args &&...args)
@@ -85,13 +618,41 @@ public:
 	Component &get(Entity e)
 	{
 		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		return components[*sparse.slot(e.index())];
+	}
+
+	// Returns the component of an entity, or nullptr if it has none; a single lookup instead of has() followed by get()
+	Component *find(Entity e)
+	{
+		unsigned int index = sparse.find(e, entities);
+		return index == INVALID_INDEX ? nullptr : &components[index];
+	}
+
+	// Change tracking: writers that want their changes to be seen call mark_changed after modifying
+	// a component; readers remember the tick of their last pass (see ECSRegistry::advance_tick) and
+	// only redo the work for components that changed since then. New components count as changed.
+	void mark_changed(Entity e)
+	{
+		assert(has(e) && "Entity not contained in ECS registry");
+		change_ticks[*sparse.slot(e.index())] = change_tick.load(std::memory_order_relaxed);
+	}
+	// For code that only holds the component, e.g. its own member functions
+	void mark_changed(const Component &component)
+	{
+		assert(&component >= components.data() && &component < components.data() + components.size() && "Component not stored in this container");
+		change_ticks[&component - components.data()] = change_tick.load(std::memory_order_relaxed);
+	}
+	bool changed_since(Entity e, ChangeTick tick)
+	{
+		assert(has(e) && "Entity not contained in ECS registry");
+		return change_ticks[*sparse.slot(e.index())] > tick;
 	}
 
 	// Check if entity has a component of type 'Component'
+	// The stored handle is compared as well, so a stale handle whose index was recycled is rejected
 	bool has(Entity entity)
 	{
-		return map_entity_componentID.count(entity) > 0;
+		return sparse.find(entity, entities) != INVALID_INDEX;
 	}
 
 	// Remove an component and pack the container to re-use the empty space
@@ -100,28 +661,39 @@ public:
 		if (has(e))
 		{
 			// Get the current position
-			int cID = map_entity_componentID[e];
+			unsigned int &slot = *sparse.slot(e.index());
+			unsigned int cID = slot;
 
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			change_ticks[cID] = change_ticks.back();
+			*sparse.slot(entities.back().index()) = cID;
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			slot = INVALID_INDEX;
 			components.pop_back();
 			entities.pop_back();
-			// Note, one could mark the id for re-use
+			change_ticks.pop_back();
+			if (signatures)
+				signatures->clear_bit(e, component_id);
 		}
 	};
 
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		// only touch the slots that are in use, pages stay allocated for the next level
+		for (Entity e : entities)
+		{
+			*sparse.slot(e.index()) = INVALID_INDEX;
+			if (signatures)
+				signatures->clear_bit(e, component_id);
+		}
 		components.clear();
 		entities.clear();
+		change_ticks.clear();
 	}
 
 	// Report the number of components of type 'Component'
@@ -130,20 +702,270 @@ public:
 		return components.size();
 	}
 
+	void save(SnapshotBuffer &buffer)
+	{
+		buffer.write_vector(entities);
+		SnapshotSerializer<Component>::write(buffer, components);
+	}
+
+	void load(SnapshotBuffer &buffer)
+	{
+		clear();
+		buffer.read_vector(entities);
+		SnapshotSerializer<Component>::read(buffer, components);
+		assert(entities.size() == components.size());
+		// everything restored counts as changed
+		change_ticks.assign(components.size(), change_tick.load(std::memory_order_relaxed));
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			sparse.slot_or_create(entities[i].index()) = i;
+			if (signatures)
+				signatures->set_bit(entities[i], component_id);
+		}
+		peak_count = std::max(peak_count, components.size());
+	}
+
+	unsigned int type_id() const
+	{
+		return container_type_id<ComponentContainer<Component>>();
+	}
+
+	ContainerStats stats()
+	{
+		ContainerStats stats;
+		stats.count = components.size();
+		stats.capacity = components.capacity();
+		stats.component_bytes = components.capacity() * sizeof(Component);
+		stats.index_bytes = entities.capacity() * sizeof(Entity) + change_ticks.capacity() * sizeof(ChangeTick) +
+												sort_order.capacity() * sizeof(unsigned int) + sparse.bytes();
+		stats.reallocations = reallocations;
+		stats.peak_count = peak_count;
+		return stats;
+	}
+
+	// Direct access for component types with a single instance, e.g. the player, a boss or the screen state
+	Component &singleton()
+	{
+		assert(!components.empty() && "Singleton component does not exist");
+		return components[0];
+	}
+	Entity singleton_entity()
+	{
+		assert(!entities.empty() && "Singleton component does not exist");
+		return entities[0];
+	}
+
 	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	// The comparison receives entities and may look their components up, e.g. through registry.motions.get(e)
 	template <class Compare>
 	void sort(Compare comparisonFunction)
 	{
-		// First sort the entity list as desired
-		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new;
-		components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e)
-									 { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new);				 // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
+		// First sort positions, so the container stays intact for lookups made by the comparison
+		sort_order.resize(entities.size());
+		for (unsigned int i = 0; i < sort_order.size(); i++)
+			sort_order[i] = i;
+		std::sort(sort_order.begin(), sort_order.end(), [&](unsigned int a, unsigned int b)
+							{ return comparisonFunction(entities[a], entities[b]); });
+
+		// Now move every element to its new position in place, following the cycles of the permutation
+		// sort_order[i] is the old position of the element that goes to i, and is set to i once placed
+		for (unsigned int i = 0; i < sort_order.size(); i++)
+		{
+			if (sort_order[i] == i)
+				continue;
+			Entity displaced_entity = entities[i];
+			Component displaced = std::move(components[i]);
+			ChangeTick displaced_tick = change_ticks[i];
+			unsigned int target = i;
+			while (sort_order[target] != i)
+			{
+				unsigned int source = sort_order[target];
+				entities[target] = entities[source];
+				components[target] = std::move(components[source]);
+				change_ticks[target] = change_ticks[source];
+				*sparse.slot(entities[target].index()) = target;
+				sort_order[target] = target;
+				target = source;
+			}
+			entities[target] = displaced_entity;
+			components[target] = std::move(displaced);
+			change_ticks[target] = displaced_tick;
+			*sparse.slot(entities[target].index()) = target;
+			sort_order[target] = target;
+		}
+	}
+
+	// Same result as sort, but cheap when the container is nearly sorted already, e.g. when it is
+	// re-sorted every frame by a key that changes slowly. Insertion sort by adjacent swaps keeps
+	// entities, components and sparse indices in sync at every step; if the order is too far off
+	// it falls back to the full sort.
+	template <class Compare>
+	void sort_incremental(Compare comparisonFunction)
+	{
+		size_t swap_budget = 4 * entities.size() + 16;
+		for (unsigned int i = 1; i < entities.size(); i++)
+		{
+			for (unsigned int j = i; j > 0 && comparisonFunction(entities[j], entities[j - 1]); j--)
+			{
+				if (swap_budget-- == 0)
+				{
+					sort(comparisonFunction);
+					return;
+				}
+				std::swap(entities[j], entities[j - 1]);
+				std::swap(components[j], components[j - 1]);
+				std::swap(change_ticks[j], change_ticks[j - 1]);
+				*sparse.slot(entities[j].index()) = j;
+				*sparse.slot(entities[j - 1].index()) = j - 1;
+			}
+		}
+	}
+};
+
+template <typename Component>
+const unsigned int ComponentContainer<Component>::INVALID_INDEX;
+
+// Storage for tag components: empty structs that only mark an entity (e.g. DebugComponent)
+// Only membership is kept, in a sparse set without a payload array.
+template <typename Tag>
+class TagContainer : public ContainerInterface
+{
+	static_assert(std::is_empty<Tag>::value, "TagContainer is meant for empty components");
+	SparseIndex sparse;
+
+public:
+	// The tagged entities
+	std::vector<Entity> entities;
+
+	// Tags carry no data, so any constructor arguments (e.g. emplace(entity, SpinArea())) are ignored
+	template <typename... Args>
+	void emplace(Entity e, Args &&...)
+	{
+		assert(!has(e) && "Entity already contained in ECS registry");
+		sparse.slot_or_create(e.index()) = (unsigned int)entities.size();
+		size_t capacity = entities.capacity();
+		entities.push_back(e);
+		if (entities.capacity() != capacity)
+			reallocations++;
+		peak_count = std::max(peak_count, entities.size());
+		if (signatures)
+			signatures->set_bit(e, component_id);
+	}
+
+	bool has(Entity entity)
+	{
+		return sparse.find(entity, entities) != SparseIndex::INVALID_INDEX;
+	}
+
+	void remove(Entity e)
+	{
+		unsigned int index = sparse.find(e, entities);
+		if (index == SparseIndex::INVALID_INDEX)
+			return;
+		entities[index] = entities.back();
+		*sparse.slot(entities.back().index()) = index;
+		*sparse.slot(e.index()) = SparseIndex::INVALID_INDEX;
+		entities.pop_back();
+		if (signatures)
+			signatures->clear_bit(e, component_id);
+	}
+
+	void clear()
+	{
+		for (Entity e : entities)
+		{
+			*sparse.slot(e.index()) = SparseIndex::INVALID_INDEX;
+			if (signatures)
+				signatures->clear_bit(e, component_id);
+		}
+		entities.clear();
+	}
+
+	size_t size()
+	{
+		return entities.size();
+	}
+
+	void save(SnapshotBuffer &buffer)
+	{
+		buffer.write_vector(entities);
+	}
+
+	void load(SnapshotBuffer &buffer)
+	{
+		clear();
+		buffer.read_vector(entities);
 		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+		{
+			sparse.slot_or_create(entities[i].index()) = i;
+			if (signatures)
+				signatures->set_bit(entities[i], component_id);
+		}
+		peak_count = std::max(peak_count, entities.size());
+	}
+
+	unsigned int type_id() const
+	{
+		return container_type_id<TagContainer<Tag>>();
+	}
+
+	// Tags have no component array, the entity list is all they store
+	ContainerStats stats()
+	{
+		ContainerStats stats;
+		stats.count = entities.size();
+		stats.capacity = entities.capacity();
+		stats.index_bytes = entities.capacity() * sizeof(Entity) + sparse.bytes();
+		stats.reallocations = reallocations;
+		stats.peak_count = peak_count;
+		return stats;
+	}
+};
+
+// The container type a component is stored in: empty structs get membership-only tag storage
+template <typename Component>
+using ComponentStorage = typename std::conditional<std::is_empty<Component>::value, TagContainer<Component>, ComponentContainer<Component>>::type;
+
+// A join over several containers, e.g. all entities that have both a Motion and a PhysicsBody
+// Iteration is driven by the smallest container, the others are probed with one sparse lookup each.
+// Components must not be added to or removed from the viewed containers while iterating.
+template <typename... Components>
+class ComponentView
+{
+	std::tuple<ComponentContainer<Components> *...> containers;
+	std::vector<Entity> *driver = nullptr;
+
+	template <typename Callback, size_t... I>
+	void each_impl(Callback &callback, std::index_sequence<I...>)
+	{
+		for (Entity entity : *driver)
+		{
+			std::tuple<Components *...> found(std::get<I>(containers)->find(entity)...);
+			bool complete = true;
+			(void)std::initializer_list<int>{(complete = complete && std::get<I>(found) != nullptr, 0)...};
+			if (complete)
+				callback(entity, *std::get<I>(found)...);
+		}
+	}
+
+public:
+	ComponentView(ComponentContainer<Components> &...component_containers) : containers(&component_containers...)
+	{
+		for (std::vector<Entity> *entities : {&component_containers.entities...})
+			if (driver == nullptr || entities->size() < driver->size())
+				driver = entities;
+	}
+
+	// Calls callback(Entity, Components &...) for every entity that has all requested components
+	template <typename Callback>
+	void each(Callback callback)
+	{
+		each_impl(callback, std::index_sequence_for<Components...>());
+	}
+
+	// Upper bound on the number of entities visited
+	size_t size_hint() const
+	{
+		return driver->size();
 	}
 };
@@ -3,11 +3,34 @@
 
 #include "tiny_ecs.hpp"
 #include "components.hpp"
+#include "component_snapshot.hpp"
+
+// A structural change recorded during iteration and applied by ECSRegistry::flush_commands()
+struct EntityCommand
+{
+	enum class Type
+	{
+		DESTROY,
+		REMOVE,
+		EMPLACE
+	};
+	Type type;
+	Entity entity;
+	ContainerInterface *container;		// for REMOVE
+	std::function<void()> emplace; // for EMPLACE, inserts the captured component
+};
 
 class ECSRegistry
 {
 	// Callbacks to remove a particular or all entities in the system
 	std::vector<ContainerInterface *> registry_list;
+	// Deferred create/add/remove operations, kept in recording order
+	std::vector<EntityCommand> command_buffer;
+	// Registered containers by container_type_id, used by container<T>() and view<T...>()
+	// Filled once in the constructor and only read afterwards, so lookups are safe from any thread.
+	std::vector<ContainerInterface *> containers_by_type;
+	// Which containers each entity has components in, bit i stands for registry_list[i]
+	ComponentSignatures signatures;
 
 public:
 	// Manually created list of all components this game has
@@ -25,7 +48,7 @@ public:
 	ComponentContainer<RenderRequest> renderRequests;
 	ComponentContainer<ScreenState> screenStates;
 	ComponentContainer<Damage> damages;
-	ComponentContainer<DebugComponent> debugComponents;
+	TagContainer<DebugComponent> debugComponents;
 	ComponentContainer<vec3> colors;
 	ComponentContainer<float> opacities;
 	ComponentContainer<Enemy> enemies;
@@ -37,7 +60,7 @@ public:
 	ComponentContainer<Flow> flows;
 	ComponentContainer<Chef> chef;
 	ComponentContainer<Pan> pans;
-	ComponentContainer<SpinArea> spinareas;
+	TagContainer<SpinArea> spinareas;
 	ComponentContainer<Attachment> attachments;
 	ComponentContainer<SpriteAnimation> spriteAnimations;
 	ComponentContainer<CameraUI> cameraUI;
@@ -46,14 +69,20 @@ public:
 	ComponentContainer<Knight> knight;
 	ComponentContainer<Prince> prince;
 	ComponentContainer<King> king;
-	ComponentContainer<PopupUI> popupUI;
-	ComponentContainer<Fountain> fountains;
+	TagContainer<PopupUI> popupUI;
+	TagContainer<Fountain> fountains;
 	ComponentContainer<TreasureBox> treasureBoxes;
 	ComponentContainer<BoneAnimation> boneAnimations;
 	ComponentContainer<MeshBones> meshBones;
 	ComponentContainer<PlayerRemnant> playerRemnants;
 	ComponentContainer<RangedMinion> rangedminions;
-	ComponentContainer<BackGround> backgrounds;
+	TagContainer<BackGround> backgrounds;
+	ComponentContainer<Tilemap> tilemaps;
+
+	// Incrementally maintained entity sets, see EntityGroup
+	EntityGroup live_enemies; // Enemy and Health, not dead yet
+	EntityGroup live_minions; // live_enemies without the bosses
+	EntityGroup bosses;				// Enemy and one of Chef, Knight, Prince or King
 
 	// constructor that adds all containers for looping over them
 	// IMPORTANT: Don't forget to add any newly added containers!
@@ -102,6 +131,166 @@ public:
 		registry_list.push_back(&playerRemnants);
 		registry_list.push_back(&rangedminions);
 		registry_list.push_back(&backgrounds);
+		registry_list.push_back(&tilemaps);
+
+		for (unsigned int i = 0; i < registry_list.size(); i++)
+		{
+			registry_list[i]->register_signature(&signatures, i);
+			unsigned int type_id = registry_list[i]->type_id();
+			if (type_id >= containers_by_type.size())
+				containers_by_type.resize(type_id + 1, nullptr);
+			containers_by_type[type_id] = registry_list[i];
+		}
+
+		ComponentMask boss_mask = mask_of<Chef, Knight, Prince, King>();
+		auto is_alive = [this](Entity e)
+		{ return !healths.get(e).is_dead; };
+		live_enemies.define(&signatures, mask_of<Enemy, Health>(), 0, 0, is_alive);
+		live_minions.define(&signatures, mask_of<Enemy, Health>(), 0, boss_mask, is_alive);
+		bosses.define(&signatures, mask_of<Enemy>(), boss_mask, 0);
+	}
+
+	// Bits of all listed component types, e.g. mask_of<Motion, PhysicsBody>()
+	template <typename... Components>
+	ComponentMask mask_of()
+	{
+		ComponentMask mask = 0;
+		(void)std::initializer_list<int>{(mask |= ComponentMask(1) << container<Components>().component_id, 0)...};
+		return mask;
+	}
+
+	// Starts a new change epoch and returns the previous one
+	// A system that keeps derived data stores the result at the start of its pass; next time,
+	// container.changed_since(e, stored) tells which components were marked after that.
+	ChangeTick advance_tick()
+	{
+		return ContainerInterface::change_tick.fetch_add(1);
+	}
+
+	// Call after changing a component field that group filters look at, e.g. Health::is_dead
+	void refresh_groups(Entity e)
+	{
+		signatures.refresh_groups(e);
+	}
+
+	// The containers e currently has components in
+	ComponentMask signature_of(Entity e)
+	{
+		return e.is_valid() ? signatures.get(e) : 0;
+	}
+
+	// True if e has every one of the listed components
+	template <typename... Components>
+	bool has_all(Entity e)
+	{
+		ComponentMask mask = mask_of<Components...>();
+		return (signature_of(e) & mask) == mask;
+	}
+
+	// True if e has at least one of the listed components
+	template <typename... Components>
+	bool has_any(Entity e)
+	{
+		return (signature_of(e) & mask_of<Components...>()) != 0;
+	}
+
+	// The container that stores components of type Component, an index into containers_by_type
+	template <typename Component>
+	ComponentStorage<Component> &container()
+	{
+		unsigned int type_id = container_type_id<ComponentStorage<Component>>();
+		assert(type_id < containers_by_type.size() && containers_by_type[type_id] != nullptr && "Component type not registered in ECS registry");
+		return *static_cast<ComponentStorage<Component> *>(containers_by_type[type_id]);
+	}
+
+	// Iterate all entities having every one of the listed components, e.g.
+	// registry.view<Motion, PhysicsBody>().each([](Entity e, Motion &motion, PhysicsBody &body) { ... });
+	template <typename... Components>
+	ComponentView<Components...> view()
+	{
+		return ComponentView<Components...>(container<Components>()...);
+	}
+
+	// Deferred structural changes: systems record them while iterating containers and they are
+	// applied at the sync points between systems (see main.cpp), so loops never see the containers
+	// they walk shrink or grow underneath them.
+
+	// A new entity handle for components added through defer_emplace
+	Entity defer_create()
+	{
+		return Entity();
+	}
+
+	template <typename Component, typename... Args>
+	void defer_emplace(Entity e, Args &&...args)
+	{
+		ComponentStorage<Component> *target = &container<Component>();
+		Component component(std::forward<Args>(args)...);
+		command_buffer.push_back({EntityCommand::Type::EMPLACE, e, nullptr, [target, e, component]() mutable
+															{ target->emplace(e, std::move(component)); }});
+	}
+
+	template <typename Component>
+	void defer_remove(Entity e)
+	{
+		command_buffer.push_back({EntityCommand::Type::REMOVE, e, &container<Component>(), nullptr});
+	}
+
+	// Deferred remove_all_components_of
+	void defer_destroy(Entity e)
+	{
+		command_buffer.push_back({EntityCommand::Type::DESTROY, e, nullptr, nullptr});
+	}
+
+	// Sync point: apply all recorded commands in order
+	// Commands for entities destroyed in the meantime are dropped
+	void flush_commands()
+	{
+		for (size_t i = 0; i < command_buffer.size(); i++)
+		{
+			EntityCommand &command = command_buffer[i];
+			if (!command.entity.is_valid())
+				continue;
+			switch (command.type)
+			{
+			case EntityCommand::Type::DESTROY:
+				remove_all_components_of(command.entity);
+				break;
+			case EntityCommand::Type::REMOVE:
+				command.container->remove(command.entity);
+				break;
+			case EntityCommand::Type::EMPLACE:
+				command.emplace();
+				break;
+			}
+		}
+		command_buffer.clear(); // keeps the capacity for the next frame
+		signatures.update_groups();
+	}
+
+	bool has_pending_commands() const
+	{
+		return !command_buffer.empty();
+	}
+
+	// Binary copy of every container and of the entity allocator
+	void snapshot(SnapshotBuffer &buffer)
+	{
+		buffer.clear();
+		Entity::save_allocator(buffer);
+		for (ContainerInterface *reg : registry_list)
+			reg->save(buffer);
+	}
+
+	// Replace the whole registry by a snapshot; handles taken before the snapshot are valid again
+	// Pending deferred commands belong to the discarded state and are dropped.
+	void restore(SnapshotBuffer &buffer)
+	{
+		command_buffer.clear();
+		buffer.rewind();
+		Entity::restore_allocator(buffer);
+		for (ContainerInterface *reg : registry_list)
+			reg->load(buffer);
 	}
 
 	void clear_all_components()
@@ -110,26 +299,52 @@ public:
 			reg->clear();
 	}
 
+	// Memory and occupancy of every registered container, in registry_list order
+	std::vector<ContainerStats> container_stats()
+	{
+		std::vector<ContainerStats> all;
+		all.reserve(registry_list.size());
+		for (ContainerInterface *reg : registry_list)
+		{
+			all.push_back(reg->stats());
+			all.back().name = readable_type_name(typeid(*reg));
+		}
+		return all;
+	}
+
+	// Starts a new peak measurement, called when a level is loaded
+	void reset_container_peaks()
+	{
+		for (ContainerInterface *reg : registry_list)
+			reg->reset_peak();
+	}
+
 	void list_all_components()
 	{
 		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface *reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
+		printf("%-40s %6s %6s %6s %9s %9s %7s\n", "container", "count", "peak", "cap", "bytes", "index", "reallocs");
+		for (const ContainerStats &stats : container_stats())
+			if (stats.capacity > 0)
+				printf("%-40s %6d %6d %6d %9d %9d %7d\n", stats.name.c_str(), (int)stats.count, (int)stats.peak_count, (int)stats.capacity,
+							 (int)stats.component_bytes, (int)stats.index_bytes, (int)stats.reallocations);
 	}
 
 	void list_all_components_of(Entity e)
 	{
 		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface *reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
+		for (ComponentMask mask = signature_of(e); mask != 0; mask &= mask - 1)
+			printf("type %s\n", readable_type_name(typeid(*registry_list[lowest_component_bit(mask)])).c_str());
 	}
 
+	// Removes every component of e and destroys the entity, so its index can be recycled
+	// Only the containers named in the entity's signature are visited
 	void remove_all_components_of(Entity e)
 	{
-		for (ContainerInterface *reg : registry_list)
-			reg->remove(e);
+		if (!e.is_valid())
+			return;
+		for (ComponentMask mask = signatures.get(e); mask != 0; mask &= mask - 1)
+			registry_list[lowest_component_bit(mask)]->remove(e);
+		Entity::destroy(e);
 	}
 };
 
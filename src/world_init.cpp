@@ -3,72 +3,111 @@
 #include "ai_system.hpp"
 #include "iostream"
 #include "world_system.hpp"
+#include "prefab.hpp"
 
 extern float player_max_health;
 extern float player_max_energy;
 
-// Create floor tile entity and add to registry.
-Entity createFloorTile(RenderSystem *renderer, vec2 pos)
+// Prefabs hold the renderer's meshes, there is a single renderer for the whole game
+static const Prefab &floor_tile_prefab(RenderSystem *renderer)
 {
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Setting initial motion values
-	Motion &motion = registry.motions.emplace(entity);
-	motion.position = pos;
-	motion.angle = 0.f;
-	motion.velocity = {0.f, 0.f};
-	motion.scale = {mesh.original_size.x * TILE_SCALE, mesh.original_size.x * TILE_SCALE};
-	motion.ignore_render_order = true;
-	motion.layer = 0;
-	// std::cout << mesh.original_size.x << "," << mesh.original_size.y << std::endl;
-	// create an empty floor tile component for our character
-	registry.renderRequests.insert(
-			entity,
-			{TEXTURE_ASSET_ID::FLOOR_TILE,
-			 EFFECT_ASSET_ID::TEXTURED,
-			 GEOMETRY_BUFFER_ID::SPRITE});
+	static Prefab prefab = [renderer]()
+	{
+		// Store a reference to the potentially re-used mesh object
+		Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
+
+		Motion motion = Motion();
+		motion.angle = 0.f;
+		motion.velocity = {0.f, 0.f};
+		motion.scale = {mesh.original_size.x * TILE_SCALE, mesh.original_size.x * TILE_SCALE};
+		motion.ignore_render_order = true;
+		motion.layer = 0;
+
+		return Prefab()
+				.with(registry.meshPtrs, &mesh)
+				.with(registry.motions, motion)
+				.with(registry.renderRequests,
+							{TEXTURE_ASSET_ID::FLOOR_TILE,
+							 EFFECT_ASSET_ID::TEXTURED,
+							 GEOMETRY_BUFFER_ID::SPRITE});
+	}();
+	return prefab;
+}
 
-	return entity;
+// Wall tiles are only drawn, they collide through the level's Tilemap
+static const Prefab &wall_prefab(RenderSystem *renderer)
+{
+	static Prefab prefab = [renderer]()
+	{
+		Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
+
+		Motion motion = Motion();
+		motion.angle = 0.f;
+		motion.velocity = {0.f, 0.f};
+		motion.scale = {mesh.original_size.x * TILE_SCALE, mesh.original_size.x * TILE_SCALE};
+		motion.bb_scale = motion.scale;
+		motion.bb_offset = {0.f, 0.f};
+		motion.ignore_render_order = true;
+		motion.layer = 0;
+
+		return Prefab()
+				.with(registry.meshPtrs, &mesh)
+				.with(registry.motions, motion)
+				.with(registry.renderRequests,
+							{TEXTURE_ASSET_ID::WALL,
+							 EFFECT_ASSET_ID::TEXTURED,
+							 GEOMETRY_BUFFER_ID::SPRITE});
+	}();
+	return prefab;
 }
 
-Entity createWall(RenderSystem *renderer, vec2 pos)
+Entity createTilemap(const std::vector<std::vector<int>> &cells, float tile_size)
 {
 	auto entity = Entity();
 
-	// Get the mesh for the wall, similar to how you got the floor mesh
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
+	Tilemap &tilemap = registry.tilemaps.emplace(entity);
+	tilemap.cells = &cells;
+	tilemap.tile_size = tile_size;
+	registry.physicsBodies.insert(entity, {BodyType::STATIC, COLLISION_WALL});
 
-	// Set initial motion values, ensuring the wall is properly scaled and positioned
-	Motion &motion = registry.motions.emplace(entity);
-	motion.position = pos; // Use the same position or adjust for wall placement
-	motion.angle = 0.f;
-	motion.velocity = {0.f, 0.f};
-	motion.scale = {mesh.original_size.x * TILE_SCALE, mesh.original_size.x * TILE_SCALE};
-	motion.bb_scale = motion.scale;
-	motion.bb_offset = {0.f, 0.f};
-	motion.ignore_render_order = true;
-	motion.layer = 0;
+	return entity;
+}
 
-	// Print mesh size for debugging if needed
-	// std::cout << mesh.original_size.x << "," << mesh.original_size.y << std::endl;
+// Instantiates prefab once per position
+static std::vector<Entity> instantiate_at(const Prefab &prefab, const std::vector<vec2> &positions)
+{
+	std::vector<Entity> entities;
+	prefab.instantiate(positions.size(), entities);
+	for (size_t i = 0; i < entities.size(); i++)
+		registry.motions.get(entities[i]).position = positions[i];
+	return entities;
+}
 
-	registry.physicsBodies.insert(entity, {BodyType::STATIC});
+// Create floor tile entity and add to registry.
+Entity createFloorTile(RenderSystem *renderer, vec2 pos)
+{
+	Entity entity = floor_tile_prefab(renderer).instantiate();
+	registry.motions.get(entity).position = pos;
+	return entity;
+}
 
-	// Set up the render request for the wall
-	registry.renderRequests.insert(
-			entity,
-			{TEXTURE_ASSET_ID::WALL, // Make sure to use a wall texture
-			 EFFECT_ASSET_ID::TEXTURED,
-			 GEOMETRY_BUFFER_ID::SPRITE});
+std::vector<Entity> createFloorTiles(RenderSystem *renderer, const std::vector<vec2> &positions)
+{
+	return instantiate_at(floor_tile_prefab(renderer), positions);
+}
 
+Entity createWall(RenderSystem *renderer, vec2 pos)
+{
+	Entity entity = wall_prefab(renderer).instantiate();
+	registry.motions.get(entity).position = pos;
 	return entity;
 }
 
+std::vector<Entity> createWalls(RenderSystem *renderer, const std::vector<vec2> &positions)
+{
+	return instantiate_at(wall_prefab(renderer), positions);
+}
+
 // void createRoom(RenderSystem* renderer, WallMap& wallMap, int x_start, int y_start, int width, int height, float tile_scale) {
 //	for (int i = x_start; i < x_start + width; ++i) {
 //		for (int j = y_start; j < y_start + height; ++j) {
@@ -111,7 +150,7 @@ Entity createSpy(RenderSystem *renderer, vec2 pos)
 	Player &player = registry.players.emplace(entity);
 	player.last_health = player_max_health;
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_PLAYER});
 	registry.renderRequests.insert(
 			entity,
 			{TEXTURE_ASSET_ID::SPY, // TEXTURE_COUNT indicates that no texture is needed
@@ -153,7 +192,7 @@ Entity createChef(RenderSystem *renderer, vec2 pos)
 	registry.enemies.emplace(entity);
 
 	auto &bossAnimation = registry.bossAnimations.emplace(entity);
-	bossAnimation.attack_1 = std::vector<TEXTURE_ASSET_ID>{
+	bossAnimation.attack_1 = ArenaVector<TEXTURE_ASSET_ID>{
 			TEXTURE_ASSET_ID::CHEF1_0,
 			TEXTURE_ASSET_ID::CHEF1_1,
 			TEXTURE_ASSET_ID::CHEF1_2,
@@ -168,7 +207,7 @@ Entity createChef(RenderSystem *renderer, vec2 pos)
 			TEXTURE_ASSET_ID::CHEF1_11,
 	};
 
-	bossAnimation.attack_2 = std::vector<TEXTURE_ASSET_ID>{
+	bossAnimation.attack_2 = ArenaVector<TEXTURE_ASSET_ID>{
 			TEXTURE_ASSET_ID::CHEF2_0,
 			TEXTURE_ASSET_ID::CHEF2_1,
 			TEXTURE_ASSET_ID::CHEF2_2,
@@ -192,7 +231,7 @@ Entity createChef(RenderSystem *renderer, vec2 pos)
 			TEXTURE_ASSET_ID::CHEF2_20,
 	};
 
-	bossAnimation.attack_3 = std::vector<TEXTURE_ASSET_ID>{
+	bossAnimation.attack_3 = ArenaVector<TEXTURE_ASSET_ID>{
 			TEXTURE_ASSET_ID::CHEF3_0,
 			TEXTURE_ASSET_ID::CHEF3_1,
 			TEXTURE_ASSET_ID::CHEF3_2,
@@ -218,7 +257,7 @@ Entity createChef(RenderSystem *renderer, vec2 pos)
 
 	bossAnimation.frame_duration = 100.f; // 0.1s per frame
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 	registry.renderRequests.insert(
 			entity,
 			{bossAnimation.attack_1[bossAnimation.current_frame], // TEXTURE_COUNT indicates that no texture is needed
@@ -262,7 +301,7 @@ Entity createKnight(RenderSystem *renderer, vec2 pos)
 
 	registry.meshBones.insert(entity, {renderer->skinned_meshes[(int)GEOMETRY_BUFFER_ID::KNIGHT].bones});
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 	registry.renderRequests.insert(
 			entity,
 			{TEXTURE_ASSET_ID::KNIGHT,
@@ -300,14 +339,14 @@ Entity createRangedMinion(RenderSystem *renderer, vec2 position)
 	registry.enemies.emplace(entity);
 
 	auto &spriteAnimation = registry.spriteAnimations.emplace(entity);
-	spriteAnimation.frames = std::vector<TEXTURE_ASSET_ID>{
+	spriteAnimation.frames = ArenaVector<TEXTURE_ASSET_ID>{
 			TEXTURE_ASSET_ID::RANGEDMINION,
 			TEXTURE_ASSET_ID::RANGEDMINION_ATTACK,
 	};
 	// spriteAnimation.current_frame = 0; // Initialize to a valid frame index
 	spriteAnimation.frame_duration = 1000.f;
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 	registry.renderRequests.insert(
 			entity,
 			{spriteAnimation.frames[spriteAnimation.current_frame],
@@ -320,18 +359,38 @@ Entity createRangedMinion(RenderSystem *renderer, vec2 position)
 	return entity;
 }
 
-Entity createArrow(RenderSystem *renderer, vec2 position, vec2 velocity)
+static const Prefab &arrow_prefab(RenderSystem *renderer)
 {
-	auto entity = Entity();
+	static Prefab prefab = [renderer]()
+	{
+		Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
+
+		Motion motion = Motion();
+		motion.scale = {100.f, 20.f};
+		motion.bb_offset = {0.f, 0.f};
+		motion.layer = 2;
+
+		return Prefab()
+				.with(registry.meshPtrs, &mesh)
+				.with(registry.motions, motion)
+				.with(registry.damages, {10.f})
+				.with(registry.physicsBodies, {BodyType::PROJECTILE, COLLISION_PROJECTILE})
+				.with(registry.renderRequests,
+							{TEXTURE_ASSET_ID::ARROW,
+							 EFFECT_ASSET_ID::TEXTURED,
+							 GEOMETRY_BUFFER_ID::SPRITE});
+	}();
+	return prefab;
+}
 
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
+Entity createArrow(RenderSystem *renderer, vec2 position, vec2 velocity)
+{
+	Entity entity = arrow_prefab(renderer).instantiate();
 
-	Motion &motion = registry.motions.emplace(entity);
+	Motion &motion = registry.motions.get(entity);
 	motion.position = position;
 	motion.velocity = velocity;
 	motion.angle = atan2(velocity.y, velocity.x);
-	motion.scale = {100.f, 20.f};
 	float w = motion.scale.x;
 	float h = motion.scale.y;
 	float cos_theta = std::abs(std::cos(motion.angle));
@@ -339,19 +398,6 @@ Entity createArrow(RenderSystem *renderer, vec2 position, vec2 velocity)
 	float new_bb_width = w * cos_theta + h * sin_theta;
 	float new_bb_height = w * sin_theta + h * cos_theta;
 	motion.bb_scale = {new_bb_width, new_bb_height};
-	// motion.bb_scale = motion.scale;
-	motion.bb_offset = {0.f, 0.f};
-	motion.layer = 2;
-
-	registry.damages.insert(entity, {10.f});
-
-	registry.physicsBodies.insert(entity, {BodyType::PROJECTILE});
-
-	registry.renderRequests.insert(
-			entity,
-			{TEXTURE_ASSET_ID::ARROW,
-			 EFFECT_ASSET_ID::TEXTURED,
-			 GEOMETRY_BUFFER_ID::SPRITE});
 
 	// registry.deathTimers.emplace(entity, DeathTimer{5000.f});
 
@@ -400,7 +446,7 @@ Entity createPrince(RenderSystem *renderer, vec2 pos)
 
 	registry.meshBones.insert(entity, {renderer->skinned_meshes[(int)GEOMETRY_BUFFER_ID::PRINCE].bones});
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 	registry.renderRequests.insert(
 			entity,
 			{TEXTURE_ASSET_ID::PRINCE,
@@ -455,7 +501,7 @@ Entity createKing(RenderSystem *renderer, vec2 pos)
 
 	registry.meshBones.insert(entity, {renderer->skinned_meshes[(int)GEOMETRY_BUFFER_ID::KING].bones});
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 	registry.renderRequests.insert(
 			entity,
 			{TEXTURE_ASSET_ID::KING,
@@ -538,7 +584,7 @@ Entity createWeapon(RenderSystem *renderer, vec2 pos, WeaponType type, WeaponLev
 	motion.pivot_offset = {0.f, -0.35f};
 	motion.layer = 3;
 
-	registry.physicsBodies.insert(entity, {BodyType::NONE});
+	registry.physicsBodies.insert(entity, {BodyType::NONE, COLLISION_WEAPON});
 
 	registry.renderRequests.insert(
 			entity,
@@ -630,6 +676,13 @@ Entity createHealthBar(RenderSystem *renderer, vec2 pos, Entity owner_entity, ve
 	// Set to green
 	registry.colors.emplace(entity, color);
 
+	// enemy bars hover over their owner, the player's bar stays in the corner of the screen
+	if (!registry.players.has(owner_entity))
+	{
+		vec2 offset = registry.chef.has(owner_entity) ? vec2(-95.f, -175.f) : vec2(-105.f, -75.f);
+		attach(entity, owner_entity, offset);
+	}
+
 	return entity;
 }
 
@@ -698,15 +751,15 @@ Entity createDamageArea(Entity owner, vec2 position, vec2 scale, float damage, f
 	motion.bb_scale = scale;
 
 	registry.damages.insert(entity, {damage});
-	registry.physicsBodies.insert(entity, {BodyType::NONE});
+	registry.physicsBodies.insert(entity, {BodyType::NONE, COLLISION_DAMAGE_AREA});
 
 	DamageArea &damage_area = registry.damageAreas.emplace(entity);
 	damage_area.owner = owner;
 	damage_area.active = true;
 	damage_area.time_until_active = 0.f;				 // for damage cooldown usage
 	damage_area.time_until_destroyed = duration; // when this is 0, damage area will be removed
-	damage_area.relative_position = relative_position;
-	damage_area.offset_from_owner = offset_from_owner;
+	if (relative_position)
+		attach(entity, owner, offset_from_owner);
 
 	if (damage_cooldown == 0)
 	{
@@ -721,78 +774,93 @@ Entity createDamageArea(Entity owner, vec2 position, vec2 scale, float damage, f
 	return entity;
 }
 
-Entity createEnemy(RenderSystem *renderer, vec2 position)
+static const Prefab &enemy_prefab(RenderSystem *renderer)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
+	static Prefab prefab = [renderer]()
+	{
+		Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
+
+		Motion motion = Motion();
+		motion.angle = 0.f;
+		motion.velocity = {0, 0};
+		motion.scale = mesh.original_size * 100.f;
+		motion.scale.x *= -0.8;
+		motion.bb_scale = {60.f, 60.f};
+		motion.bb_offset = {-5.f, 25.f};
+		motion.layer = 2;
+
+		Enemy enemy = Enemy();
+		enemy.is_minion = true;
+
+		return Prefab()
+				.with(registry.meshPtrs, &mesh)
+				.with(registry.motions, motion)
+				.with(registry.enemies, enemy)
+				.with(registry.physicsBodies, {BodyType::KINEMATIC, COLLISION_ENEMY})
+				.with(registry.renderRequests,
+							{TEXTURE_ASSET_ID::ENEMY,
+							 EFFECT_ASSET_ID::TEXTURED,
+							 GEOMETRY_BUFFER_ID::SPRITE});
+	}();
+	return prefab;
+}
 
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-	motion.scale = mesh.original_size * 100.f;
-	motion.scale.x *= -0.8;
-	motion.bb_scale = {60.f, 60.f};
-	motion.bb_offset = {-5.f, 25.f};
-	motion.layer = 2;
+Entity createEnemy(RenderSystem *renderer, vec2 position)
+{
+	Entity entity = enemy_prefab(renderer).instantiate();
+	registry.motions.get(entity).position = position;
 
 	// Initialize the animation component with frames
+	// (not part of the prefab, the frames live in the level arena)
 	auto &spriteAnimation = registry.spriteAnimations.emplace(entity);
-	spriteAnimation.frames = std::vector<TEXTURE_ASSET_ID>{
+	spriteAnimation.frames = ArenaVector<TEXTURE_ASSET_ID>{
 			TEXTURE_ASSET_ID::ENEMY,
 			TEXTURE_ASSET_ID::ENEMY_ATTACK,
 	};
 	spriteAnimation.frame_duration = 1000.f; // Set duration for each frame (adjust as needed)
 
-	Enemy &enemy = registry.enemies.emplace(entity);
-	enemy.is_minion = true;
-
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
-	registry.renderRequests.insert(
-			entity,
-			{spriteAnimation.frames[spriteAnimation.current_frame],
-			 EFFECT_ASSET_ID::TEXTURED,
-			 GEOMETRY_BUFFER_ID::SPRITE});
-
 	Entity healthbar = createHealthBar(renderer, position + vec2(0.f, 50.f), entity, vec3(1.f,0.f,0.f));
 	registry.healths.insert(entity, {100.f, 100.f, healthbar});
 
 	return entity;
 }
 
-Entity createTomato(RenderSystem *renderer, vec2 position, vec2 velocity)
+static const Prefab &tomato_prefab(RenderSystem *renderer)
 {
-	// Reserve en entity
-	auto entity = Entity();
+	static Prefab prefab = [renderer]()
+	{
+		Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
+
+		Motion motion = Motion();
+		motion.angle = 0.f;
+		motion.scale = mesh.original_size * 100.f;
+		motion.scale.x *= -0.8;
+		motion.bb_scale = {30.f, 30.f};
+		motion.bb_offset = {0.f, 0.f};
+		motion.layer = 2;
+
+		return Prefab()
+				.with(registry.meshPtrs, &mesh)
+				.with(registry.motions, motion)
+				.with(registry.damages, {10.f})
+				.with(registry.physicsBodies, {BodyType::PROJECTILE, COLLISION_PROJECTILE})
+				.with(registry.renderRequests,
+							{TEXTURE_ASSET_ID::TOMATO,
+							 EFFECT_ASSET_ID::TEXTURED,
+							 GEOMETRY_BUFFER_ID::SPRITE});
+	}();
+	return prefab;
+}
 
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
+Entity createTomato(RenderSystem *renderer, vec2 position, vec2 velocity)
+{
+	Entity entity = tomato_prefab(renderer).instantiate();
 
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = velocity;
+	Motion &motion = registry.motions.get(entity);
 	motion.position = position;
-	motion.scale = mesh.original_size * 100.f;
-	motion.scale.x *= -0.8;
-	motion.bb_scale = {30.f, 30.f};
-	motion.bb_offset = {0.f, 0.f};
-	motion.layer = 2;
+	motion.velocity = velocity;
 
 	std::cout << "create tomato" << std::endl;
-	registry.damages.insert(entity, {10.f});
-	registry.physicsBodies.insert(entity, {BodyType::PROJECTILE});
-	registry.renderRequests.insert(
-			entity,
-			{TEXTURE_ASSET_ID::TOMATO,
-			 EFFECT_ASSET_ID::TEXTURED,
-			 GEOMETRY_BUFFER_ID::SPRITE});
 
 	// TODO: Need to disappear after hitting player or wall or boundaries.
 	return entity;
@@ -820,7 +888,7 @@ Entity createPan(RenderSystem *renderer, vec2 position, vec2 velocity)
 
 	// Create an (empty) Bug component to be able to refer to all bug
 	registry.pans.emplace(entity, Pan(20.f));
-	registry.physicsBodies.insert(entity, {BodyType::NONE});
+	registry.physicsBodies.insert(entity, {BodyType::NONE, COLLISION_PAN});
 	registry.renderRequests.insert(
 			entity,
 			{TEXTURE_ASSET_ID::PAN,
@@ -885,12 +953,21 @@ Entity createSpinArea(Entity chef_entity)
 	motion.bb_scale = motion.scale;
 	motion.bb_offset = vec2(0.f, 0.f);
 
-	registry.attachments.emplace(entity, Attachment(chef_entity));
+	attach(entity, chef_entity, vec2(0.f, 0.f));
 	registry.spinareas.emplace(entity, SpinArea());
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 	return entity;
 }
 
+Attachment &attach(Entity child, Entity parent, vec2 offset)
+{
+	Attachment &attachment = registry.attachments.insert(child, Attachment(parent, offset));
+	Attachment *parent_attachment = registry.attachments.find(parent);
+	if (parent_attachment != nullptr)
+		attachment.depth = parent_attachment->depth + 1;
+	return attachment;
+}
+
 Entity createBackdrop(RenderSystem *renderer)
 {
 	auto entity = Entity();
@@ -999,7 +1076,7 @@ Entity createTreasureBox(RenderSystem *renderer, vec2 pos, TreasureBoxItem item,
 	treasureBox.weapon_level = weapon_level;
 	treasureBox.weapon_type = weapon_type;
 
-	registry.physicsBodies.insert(entity, {BodyType::STATIC});
+	registry.physicsBodies.insert(entity, {BodyType::STATIC, COLLISION_WALL});
 	registry.renderRequests.insert(
 			entity,
 			{TEXTURE_ASSET_ID::TREASURE_BOX,
@@ -1069,7 +1146,7 @@ Entity createSoldier(RenderSystem *renderer, vec2 pos, float health, float damag
 
 	Enemy &enemy = registry.enemies.emplace(entity);
 
-	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC});
+	registry.physicsBodies.insert(entity, {BodyType::KINEMATIC, COLLISION_ENEMY});
 
 	Entity healthbar = createHealthBar(renderer, pos + vec2(0.f, 50.f), entity);
 	registry.healths.insert(entity, {health, health, healthbar});
@@ -1101,7 +1178,7 @@ Entity createFireRain(RenderSystem *renderer, vec2 pos)
 	motion.bb_offset = {0.f, 40.f};
 	motion.layer = 1;
 
-	registry.physicsBodies.insert(entity, {BodyType::NONE});
+	registry.physicsBodies.insert(entity, {BodyType::NONE, COLLISION_DAMAGE_AREA});
 
 	registry.renderRequests.insert(
 			entity,
@@ -11,9 +11,14 @@ Entity createLine(vec2 position, vec2 size, vec3 color, float angle = 0.f);
 
 // the floor tile
 Entity createFloorTile(RenderSystem *renderer, vec2 pos);
+std::vector<Entity> createFloorTiles(RenderSystem *renderer, const std::vector<vec2> &positions);
 
 // a Wall
 Entity createWall(RenderSystem *renderer, vec2 pos);
+std::vector<Entity> createWalls(RenderSystem *renderer, const std::vector<vec2> &positions);
+
+// the collider of all walls, cells is the level grid
+Entity createTilemap(const std::vector<std::vector<int>> &cells, float tile_size);
 
 Entity createSpy(RenderSystem *renderer, vec2 pos);
 
@@ -35,6 +40,9 @@ Entity createPan(RenderSystem *renderer, vec2 pos, vec2 velocity);
 
 Entity createSpinArea(Entity chef_entity);
 
+// Makes child follow parent at the given offset
+Attachment &attach(Entity child, Entity parent, vec2 offset);
+
 Entity createDamageArea(Entity owner, vec2 position, vec2 scale, float damage, float duration, float damage_cooldown = 0, bool relative_position = false, vec2 offset_from_owner = vec2(0, 0));
 
 Entity createKnight(RenderSystem *renderer, vec2 pos);
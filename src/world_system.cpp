@@ -9,6 +9,7 @@
 #include "../ext/json.hpp"
 
 #include "physics_system.hpp"
+#include "ecs_stats.hpp"
 #include "LDtkLoader/Project.hpp"
 #include <fstream>
 
@@ -227,18 +228,10 @@ float bezzy(float t, float P0, float P1, float P2)
 	return (1 - t) * (1 - t) * P0 + 2 * (1 - t) * t * P1 + t * t * P2;
 }
 
-// Update our game world
-bool WorldSystem::step(float elapsed_ms_since_last_update)
+void WorldSystem::update_fps(float elapsed_ms)
 {
-
-	elapsed_time += elapsed_ms_since_last_update / 1000.f; // ms to second convert
+	elapsed_time += elapsed_ms / 1000.f; // ms to second convert
 	frame_count++;
-
-	Player &player = registry.players.get(player_spy);
-	Motion &spy_motion = registry.motions.get(player_spy);
-	dashAvailable = player.state != PlayerState::DASHING && player.dash_cooldown_remaining_ms <= 0.0f;
-	dashInUse = (player.state == PlayerState::DASHING);
-	// saveProgress();
 	if (elapsed_time >= 1)
 	{
 		// Update FPS every second
@@ -251,6 +244,17 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 	std::stringstream title_ss;
 	title_ss << "Frames Per Second: " << fps;
 	glfwSetWindowTitle(window, title_ss.str().c_str());
+}
+
+// Update our game world
+bool WorldSystem::step(float elapsed_ms_since_last_update)
+{
+
+	Player &player = registry.players.get(player_spy);
+	Motion &spy_motion = registry.motions.get(player_spy);
+	dashAvailable = player.state != PlayerState::DASHING && player.dash_cooldown_remaining_ms <= 0.0f;
+	dashInUse = (player.state == PlayerState::DASHING);
+	// saveProgress();
 
 	// Remove debug info from the last step
 	while (registry.debugComponents.entities.size() > 0)
@@ -271,7 +275,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 	// }
 
 	assert(registry.screenStates.components.size() <= 1);
-	ScreenState &screen = registry.screenStates.components[0];
+	ScreenState &screen = registry.screenStates.singleton();
 
 	float min_counter_ms = 3000.f;
 	for (Entity entity : registry.deathTimers.entities)
@@ -339,45 +343,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 		// std::cout << "Interpolation factor: " << interpolation_factor << std::endl;
 	}
 
-	// Update health bar percentage
-	for (unsigned int i = 0; i < registry.healths.size(); i++)
-	{
-		Health &health = registry.healths.components[i];
-		Entity owner_entity = registry.healths.entities[i];
-		Entity health_bar_entity = health.healthbar;
-
-		if (registry.motions.has(owner_entity) && registry.motions.has(health_bar_entity))
-		{
-			Motion &owner_motion = registry.motions.get(owner_entity);
-			Motion &health_bar_motion = registry.motions.get(health_bar_entity);
-
-			// TODO: refactor the following lines code by introducing healthbar_offset and put code in renderer.draw()
-			if (owner_entity == player_spy)
-			{
-				health_bar_motion.position = vec2(50.f, 50.f);
-			}
-			else if (registry.chef.has(owner_entity))
-			{
-				health_bar_motion.position = owner_motion.position + vec2(-95.f, -175.f);
-			}
-			else
-			{
-				health_bar_motion.position = owner_motion.position + vec2(-105.f, -75.f);
-			}
-
-			float health_percentage = health.health / health.max_health;
-			if (registry.healthbar.has(health_bar_entity))
-			{
-				HealthBar &health_bar = registry.healthbar.get(health_bar_entity);
-				health_bar_motion.scale.x = health_bar.original_scale.x * health_percentage;
-				health_bar_motion.scale.y = health_bar.original_scale.y;
-			}
-		}
-	}
-
-	float energy_time = elapsed_ms_since_last_update / 1000.0f;
-	update_energy(energy_time);
-
 	for (int i = registry.dashes.components.size() - 1; i >= 0; i--)
 	{
 		Motion &spy_motion = registry.motions.get(player_spy);
@@ -480,33 +445,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 		}
 	}
 
-	// update animations
-	for (Entity entity : registry.spriteAnimations.entities)
-	{
-		// if in attack mode, change sprite to attack sprite
-		if (registry.enemies.has(entity) && registry.enemies.get(entity).state == EnemyState::ATTACK)
-		{
-			auto &animation = registry.spriteAnimations.get(entity);
-			auto &render_request = registry.renderRequests.get(entity);
-
-			// Increment elapsed time
-			animation.elapsed_time += elapsed_ms_since_last_update;
-
-			// Check if enough time has passed to switch to the next frame
-			if (animation.elapsed_time >= animation.frame_duration)
-			{
-				// Reset elapsed time for the next frame
-				animation.elapsed_time = 0.0f;
-
-				// Move to the next frame
-				animation.current_frame = (animation.current_frame + 1) % animation.frames.size();
-
-				// Update the texture to the current frame
-				render_request.used_texture = animation.frames[animation.current_frame];
-			}
-		}
-	}
-
 	// play attack sound for each enemy that is attacking
 	for (Entity entity : registry.enemies.entities)
 	{
@@ -587,7 +525,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 	// Process chef death and first damaged
 	if (registry.chef.size() > 0)
 	{
-		Entity chef_entity = registry.chef.entities[0];
+		Entity chef_entity = registry.chef.singleton_entity();
 		Health &chef_health = registry.healths.get(chef_entity);
 		if (chef_health.is_dead)
 		{
@@ -608,7 +546,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 
 	if (registry.knight.size() > 0)
 	{
-		Entity knight_entity = registry.knight.entities[0];
+		Entity knight_entity = registry.knight.singleton_entity();
 		Health &knight_health = registry.healths.get(knight_entity);
 		if (knight_health.is_dead)
 		{
@@ -620,7 +558,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 
 	if (registry.prince.size() > 0)
 	{
-		Entity prince_entity = registry.prince.entities[0];
+		Entity prince_entity = registry.prince.singleton_entity();
 		Health &prince_health = registry.healths.get(prince_entity);
 		if (prince_health.is_dead)
 		{
@@ -632,7 +570,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 
 	if (registry.king.size() > 0)
 	{
-		Entity king_entity = registry.king.entities[0];
+		Entity king_entity = registry.king.singleton_entity();
 		Health &king_health = registry.healths.get(king_entity);
 		if (king_health.is_dead)
 		{
@@ -837,7 +775,16 @@ void WorldSystem::restart_game()
 
 	std::string levelName = "Level_" + std::to_string(current_level);
 	std::cout << "Loading " << levelName << std::endl;
-	load_level(levelName, current_level);
+	if (level_snapshot_number == current_level && !level_snapshot.empty())
+	{
+		// same level as the last load: restore its snapshot instead of parsing the level file again
+		registry.restore(level_snapshot);
+		play_level_music(current_level);
+	}
+	else
+	{
+		load_level(levelName, current_level);
+	}
 
 	if (!background_dialogue_triggered)
 	{
@@ -862,6 +809,15 @@ void WorldSystem::load_level(const std::string &levelName, const int levelNumber
 {
 	while (registry.motions.entities.size() > 0)
 		registry.remove_all_components_of(registry.motions.entities.back());
+	while (registry.tilemaps.entities.size() > 0)
+		registry.remove_all_components_of(registry.tilemaps.entities.back());
+
+	// Every component owning arena memory belonged to an entity with a motion, so the previous
+	// level's paths, frames and keyframes can be dropped in one go
+	assert(registry.enemies.size() == 0 && registry.spriteAnimations.size() == 0 && registry.bossAnimations.size() == 0 &&
+				 registry.boneAnimations.size() == 0 && registry.treasureBoxes.size() == 0);
+	level_arena.reset();
+	registry.reset_container_peaks();
 
 	createBackgroundSprite(renderer, levelNumber);
 	// Debugging for memory/component leaks
@@ -871,12 +827,7 @@ void WorldSystem::load_level(const std::string &levelName, const int levelNumber
 
 	saveProgress(); // save on load_level
 
-	if (background_music.size() > 0)
-	{
-		Mix_VolumeMusic(80);
-		Mix_Music *level_music = background_music.size() > levelNumber ? background_music[levelNumber] : background_music[0];
-		Mix_PlayMusic(level_music, -1);
-	}
+	play_level_music(levelNumber);
 
 	ldtk::Project ldtk_project;
 	ldtk_project.loadFromFile(data_path() + "/levels/levels.ldtk");
@@ -891,9 +842,12 @@ void WorldSystem::load_level(const std::string &levelName, const int levelNumber
 
 	std::vector<std::pair<Entity, vec2>> chests;
 	std::vector<std::pair<Entity, vec2>> minions;
+	// tiles are created in bulk once the layers have been read
+	std::vector<vec2> floor_positions;
+	std::vector<vec2> wall_positions;
 
 	level_grid.clear();
-	level_grid.resize(gridWidth, std::vector<int>(gridHeight, 0)); // 0 for walkable
+	level_grid.resize(gridWidth, std::vector<int>(gridHeight, LEVEL_GRID_EMPTY));
 
 	for (const auto &layer : level.allLayers())
 	{
@@ -910,17 +864,20 @@ void WorldSystem::load_level(const std::string &levelName, const int levelNumber
 				// vec2 position = {static_cast<float>(px), static_cast<float>(py)};
 				if (layer.getName() == "Floor_Tiles")
 				{
-					level_grid[gridX][gridY] = 1; // walkable
-					createFloorTile(renderer, position);
+					level_grid[gridX][gridY] = LEVEL_GRID_FLOOR;
+					floor_positions.push_back(position);
 				}
 				else if (layer.getName() == "Wall_Tiles")
 				{
-					level_grid[gridX][gridY] = 0;
-					createWall(renderer, position);
+					level_grid[gridX][gridY] = LEVEL_GRID_WALL;
+					wall_positions.push_back(position);
 				}
 			}
 		}
 	}
+	createFloorTiles(renderer, floor_positions);
+	createWalls(renderer, wall_positions);
+	createTilemap(level_grid, TILE_SIZE);
 
 	for (const auto &layer : level.allLayers())
 	{
@@ -1038,6 +995,7 @@ void WorldSystem::load_level(const std::string &levelName, const int levelNumber
 	Player &player = registry.players.get(player_spy);
 	player.weapon = weapon;
 	player.weapon_offset = vec2(45.f, -50.f);
+	attach(weapon, player_spy, player.weapon_offset);
 
 	flowMeterEntity = createFlowMeter(renderer, {window_width_px - 100.f, window_height_px - 100.f}, 100.0f);
 
@@ -1067,6 +1025,20 @@ void WorldSystem::load_level(const std::string &levelName, const int levelNumber
 			}
 		}
 	}
+
+	// remember the freshly loaded level so that dying here does not require reloading it
+	registry.snapshot(level_snapshot);
+	level_snapshot_number = levelNumber;
+}
+
+void WorldSystem::play_level_music(int levelNumber)
+{
+	if (background_music.size() > 0)
+	{
+		Mix_VolumeMusic(80);
+		Mix_Music *level_music = background_music.size() > levelNumber ? background_music[levelNumber] : background_music[0];
+		Mix_PlayMusic(level_music, -1);
+	}
 }
 
 void WorldSystem::process_animation(AnimationName name, float t, Entity entity)
@@ -1238,7 +1210,7 @@ void WorldSystem::handle_animations(float elapsed_ms)
 
 		if (animation.elapsed_time >= animation.total_time)
 		{
-			registry.animations.remove(entity);
+			registry.defer_remove<Animation>(entity);
 		}
 	}
 
@@ -1288,12 +1260,18 @@ void WorldSystem::handle_animations(float elapsed_ms)
 			tr.scale(interpolated.scale);
 			mesh_bones.bones[i].local_transform = tr.mat;
 		}
+		registry.meshBones.mark_changed(entity);
 
 		if (animation_ends)
 		{
-			registry.boneAnimations.remove(entity);
+			registry.defer_remove<BoneAnimation>(entity);
 		}
 	}
+
+	// A deferred remove takes whatever component the entity has when it is applied. The AI re-emplaces
+	// Animation and BoneAnimation on the same entities, so the finished ones are removed right here
+	// rather than at a later sync point, where they could take a freshly started animation with them.
+	registry.flush_commands();
 }
 
 void WorldSystem::draw_mesh_debug(Entity mesh_entity, bool consider_bones)
@@ -1393,7 +1371,13 @@ void WorldSystem::handle_collisions()
 		for (uint i = 0; i < registry.physicsBodies.components.size(); i++)
 		{
 			Entity entity = registry.physicsBodies.entities[i];
-			Motion &motion = registry.motions.get(entity);
+			Motion *motion_ptr = registry.motions.find(entity);
+			if (motion_ptr == nullptr)
+			{
+				// the tilemap, its walls are drawn as sprites
+				continue;
+			}
+			Motion &motion = *motion_ptr;
 			vec3 color = {1.f, 0.f, 0.f};
 			if (registry.collisions.has(entity))
 			{
@@ -1413,7 +1397,7 @@ void WorldSystem::handle_collisions()
 		// Draw knight mesh
 		// if (registry.knight.size() > 0)
 		// {
-		// 	Entity knight_entity = registry.knight.entities[0];
+		// 	Entity knight_entity = registry.knight.singleton_entity();
 		// 	draw_mesh_debug(knight_entity, false);
 
 		// 	// to also consider bone animations:
@@ -1423,7 +1407,7 @@ void WorldSystem::handle_collisions()
 		// Draw prince mesh
 		// if (registry.prince.size() > 0)
 		// {
-		// 	Entity prince_entity = registry.prince.entities[0];
+		// 	Entity prince_entity = registry.prince.singleton_entity();
 		// 	draw_mesh_debug(prince_entity, false);
 
 		// 	// to also consider bone animations:
@@ -1433,7 +1417,7 @@ void WorldSystem::handle_collisions()
 		// Draw king mesh
 		if (registry.king.size() > 0)
 		{
-			Entity king_entity = registry.king.entities[0];
+			Entity king_entity = registry.king.singleton_entity();
 			draw_mesh_debug(king_entity, false);
 
 			// to also consider bone animations:
@@ -1602,6 +1586,7 @@ void WorldSystem::handle_collisions()
 							king.is_second_stage = true;
 							enemy_health.max_health = 600.f;
 							enemy_health.health = 600.f;
+							registry.healths.mark_changed(enemy_health);
 							king.health_percentage = 1.f;
 							continue;
 						}
@@ -1905,6 +1890,27 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 		debugging.in_debug_mode = !debugging.in_debug_mode;
 	}
 
+	// Deterministic single-threaded system schedule
+	if (key == GLFW_KEY_T && action == GLFW_PRESS)
+	{
+		debugging.single_threaded_systems = !debugging.single_threaded_systems;
+		std::cout << "Single-threaded systems: " << (debugging.single_threaded_systems ? "ON" : "OFF") << std::endl;
+	}
+
+	// ECS container overlay, also dumps the numbers next to progress.json
+	if (key == GLFW_KEY_L && action == GLFW_PRESS)
+	{
+		debugging.show_ecs_stats = !debugging.show_ecs_stats;
+		std::cout << "ECS stats: " << (debugging.show_ecs_stats ? "ON" : "OFF") << std::endl;
+		if (debugging.show_ecs_stats)
+		{
+			std::vector<ContainerStats> stats = registry.container_stats();
+			if (!write_container_stats_json(stats, PROJECT_SOURCE_DIR "/ecs_stats.json") ||
+					!write_container_stats_csv(stats, PROJECT_SOURCE_DIR "/ecs_stats.csv"))
+				std::cerr << "Failed to write ECS stats.\n";
+		}
+	}
+
 	// FPS toggle
 	if (key == GLFW_KEY_P && action == GLFW_PRESS)
 	{
@@ -1946,6 +1952,7 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 			{
 				Health &player_health = registry.healths.get(player_spy);
 				player_health.health = player_health.max_health;
+				registry.healths.mark_changed(player_health);
 				printf("Player healed to max health: %.2f / %.2f\n",
 							 player_health.health, player_health.max_health);
 				return;
@@ -2069,6 +2076,7 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 							{
 								Health &player_health = registry.healths.get(player_spy);
 								player_health.max_health += 50.f;
+								registry.healths.mark_changed(player_health);
 								player_max_health = player_health.max_health;
 								item_name = "Max Health";
 								item_description = "Max health increased by 50, now " + std::to_string(static_cast<int>(player_health.max_health));
@@ -2235,22 +2243,22 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 		// Kill the current boss
 		if (registry.chef.size() > 0)
 		{
-			Health &chef_health = registry.healths.get(registry.chef.entities[0]);
+			Health &chef_health = registry.healths.get(registry.chef.singleton_entity());
 			chef_health.take_damage(chef_health.health);
 		}
 		else if (registry.knight.size() > 0)
 		{
-			Health &knight_health = registry.healths.get(registry.knight.entities[0]);
+			Health &knight_health = registry.healths.get(registry.knight.singleton_entity());
 			knight_health.take_damage(knight_health.health);
 		}
 		else if (registry.prince.size() > 0)
 		{
-			Health &prince_health = registry.healths.get(registry.prince.entities[0]);
+			Health &prince_health = registry.healths.get(registry.prince.singleton_entity());
 			prince_health.take_damage(prince_health.health);
 		}
 		else if (registry.king.size() > 0)
 		{
-			Health &king_health = registry.healths.get(registry.king.entities[0]);
+			Health &king_health = registry.healths.get(registry.king.singleton_entity());
 			king_health.take_damage(king_health.health);
 		}
 	}
@@ -2498,6 +2506,7 @@ Weapon &WorldSystem::switchWeapon(Entity player, RenderSystem *renderer, WeaponT
 	// Attach the new weapon component to the player
 	player_comp.weapon = newWeapon;
 	player_comp.weapon_offset = vec2(45.f, -50.f);
+	attach(newWeapon, player, player_comp.weapon_offset);
 
 	printf("Switched to new weapon: Type=%d, Level=%d, Damage=%.2f, Attack Speed=%.2f\n",
 				 static_cast<int>(newType), static_cast<int>(newLevel), newWeaponComp.damage, newWeaponComp.attack_speed);
@@ -2522,9 +2531,60 @@ void WorldSystem::player_action_finished()
 	player_motion.velocity = player_movement_direction * PLAYER_SPEED * (player.state == PlayerState::SPRINTING ? SPRINTING_MULTIPLIER : 1.f);
 }
 
+// Health bars follow their owner and scale with the remaining health
+// Runs as its own scheduler task, see main.cpp
+void WorldSystem::update_health_bars()
+{
+	// only bars whose owner's health (or the bar itself) changed since the last pass are rescaled
+	ChangeTick since = health_bars_tick;
+	health_bars_tick = registry.advance_tick();
+
+	// positions follow the owners through their Attachment, see PhysicsSystem::propagate_attachments
+	registry.view<Health>().each([&](Entity owner_entity, Health &health)
+															 {
+		Motion *health_bar_motion_ptr = registry.motions.find(health.healthbar);
+		HealthBar *health_bar = registry.healthbar.find(health.healthbar);
+		if (health_bar_motion_ptr != nullptr && health_bar != nullptr && (registry.healths.changed_since(owner_entity, since) || registry.healthbar.changed_since(health.healthbar, since)))
+		{
+			float health_percentage = health.health / health.max_health;
+			health_bar_motion_ptr->scale.x = health_bar->original_scale.x * health_percentage;
+			health_bar_motion_ptr->scale.y = health_bar->original_scale.y;
+		} });
+}
+
+// Minions in attack mode cycle through their attack frames
+void WorldSystem::update_sprite_animations(float elapsed_ms)
+{
+	for (Entity entity : registry.spriteAnimations.entities)
+	{
+		// if in attack mode, change sprite to attack sprite
+		if (registry.enemies.has(entity) && registry.enemies.get(entity).state == EnemyState::ATTACK)
+		{
+			auto &animation = registry.spriteAnimations.get(entity);
+			auto &render_request = registry.renderRequests.get(entity);
+
+			// Increment elapsed time
+			animation.elapsed_time += elapsed_ms;
+
+			// Check if enough time has passed to switch to the next frame
+			if (animation.elapsed_time >= animation.frame_duration)
+			{
+				// Reset elapsed time for the next frame
+				animation.elapsed_time = 0.0f;
+
+				// Move to the next frame
+				animation.current_frame = (animation.current_frame + 1) % animation.frames.size();
+
+				// Update the texture to the current frame
+				render_request.used_texture = animation.frames[animation.current_frame];
+			}
+		}
+	}
+}
+
 void WorldSystem::update_energy(float energy_time)
 {
-	Entity player = registry.players.entities[0];
+	Entity player = registry.players.singleton_entity();
 	Energy &energy = registry.energys.get(player);
 	Player &playerComp = registry.players.get(player);
 
@@ -2598,8 +2658,12 @@ void WorldSystem::update_energy(float energy_time)
 	{
 		energy.energy = std::min(energy.max_energy, energy.energy + energyRegenRate * energy_time);
 	}
+}
 
-	// Update energy bar
+// Rescaled in a pass of its own so update_energy stays off the motions
+void WorldSystem::update_energy_bar()
+{
+	Energy &energy = registry.energys.get(registry.players.singleton_entity());
 	Motion &energyBarMotion = registry.motions.get(energy.energybar);
 	EnergyBar &energyBar = registry.energybar.get(energy.energybar);
 	float energyRatio = energy.energy / energy.max_energy;
@@ -2617,7 +2681,7 @@ void WorldSystem::trigger_dialogue(std::vector<std::string> dialogue)
 
 	time_until_dialogue_pause = DIALOGUE_PAUSE_DELAY;
 
-	// const Entity &spy_entity = registry.players.entities[0];
+	// const Entity spy_entity = registry.players.singleton_entity();
 	// Motion &spy_motion = registry.motions.get(spy_entity);
 	// createDialogueWindow(renderer, {spy_motion.position.x - 250.f, spy_motion.position.y + 60.f});
 }
@@ -2681,14 +2745,8 @@ Entity WorldSystem::find_nearest_enemy(Entity player_spy)
 	Entity nearest_enemy = static_cast<Entity>(0);
 	float min_distance = std::numeric_limits<float>::max();
 
-	for (Entity enemy : registry.enemies.entities)
+	for (Entity enemy : registry.live_enemies.entities())
 	{
-		Health &enemy_health = registry.healths.get(enemy);
-		if (enemy_health.is_dead)
-		{
-			continue;
-		}
-
 		Motion &enemy_motion = registry.motions.get(enemy);
 		float distance = length(spy_position - enemy_motion.position);
 		if (distance < min_distance)
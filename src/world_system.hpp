@@ -36,6 +36,15 @@ public:
 	// Check for collisions
 	void handle_collisions();
 
+	// Per-frame updates split out of step() so the scheduler can run them concurrently
+	void update_health_bars();
+	void update_sprite_animations(float elapsed_ms);
+	void update_energy(float energy_time);
+	void update_energy_bar();
+
+	// Once per rendered frame, the simulation may step several times or not at all in between
+	void update_fps(float elapsed_ms);
+
 	// Should the game be over ?
 	bool is_over() const;
 
@@ -55,8 +64,8 @@ private:
 	void update_camera_view();
 	void handle_animations(float elapsed_ms);
 	void process_animation(AnimationName name, float t, Entity entity);
-	void update_energy(float energy_time);
 	void load_level(const std::string &levelName, const int levelNumber);
+	void play_level_music(int levelNumber);
 	void player_action_finished();
 	bool perform_teleport_backstab(Entity player_spy);
 	Entity find_nearest_enemy(Entity player_spy);
@@ -120,6 +129,13 @@ private:
 		"You: The throne was never yours to keep. It belongs to the people you cast aside",
 		"You: You ruled with fear and blood, and called it order. Your reign ends here.",
 	};
+	// change tick of the last update_health_bars pass
+	ChangeTick health_bars_tick = 0;
+
+	// registry state right after the last load_level, restored when the player dies on that level
+	SnapshotBuffer level_snapshot;
+	int level_snapshot_number = -1;
+
 	// universal attack id, to track unique attack instances (to prevent duplicate damage in the same attack)
 	unsigned int attack_id_counter = 0;
 